@@ -31,6 +31,13 @@ namespace x86Emitter {
 	extern void EmitSibMagic( const xRegisterBase& reg1, const void* src );
 	extern void EmitSibMagic( const xRegisterBase& reg1, const xIndirectVoid& sib );
 
+	extern void EmitRex( uint regfield, const void* address );
+	extern void EmitRex( uint regfield, const xIndirectVoid& info );
+	extern void EmitRex( uint reg1, const xRegisterBase& reg2 );
+	extern void EmitRex( const xRegisterBase& reg1, const xRegisterBase& reg2 );
+	extern void EmitRex( const xRegisterBase& reg1, const void* src );
+	extern void EmitRex( const xRegisterBase& reg1, const xIndirectVoid& sib );
+
 	extern void _xMovRtoR( const xRegisterInt& to, const xRegisterInt& from );
 
 	template< typename T > inline
@@ -43,10 +50,9 @@ namespace x86Emitter {
 	template< typename T1, typename T2 > __emitinline
 		void xOpWrite( u8 prefix, u8 opcode, const T1& param1, const T2& param2 )
 	{
-		if( prefix != 0 )
-			xWrite16( (opcode<<8) | prefix );
-		else
-			xWrite8( opcode );
+		if( prefix != 0 ) xWrite8( prefix );
+		EmitRex( param1, param2 );
+		xWrite8( opcode );
 
 		EmitSibMagic( param1, param2 );
 	}
@@ -54,7 +60,9 @@ namespace x86Emitter {
 	template< typename T1, typename T2 > __emitinline
 		void xOpWrite0F( u8 prefix, u16 opcode, const T1& param1, const T2& param2 )
 	{
-		SimdPrefix( prefix, opcode );
+		if( prefix != 0 ) xWrite8( prefix );
+		EmitRex( param1, param2 );
+		SimdPrefix( 0, opcode );
 		EmitSibMagic( param1, param2 );
 	}
 
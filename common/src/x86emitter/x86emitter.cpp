@@ -213,14 +213,17 @@ const char* xRegisterBase::GetName()
 // (btw, I know this isn't a critical performance item by any means, but it's
 //  annoying simply because it *should* be an easy thing to optimize)
 
+// Register fields are only 3 bits wide; the 4th bit of registers 8-15 goes into the
+// REX prefix (see EmitRex).
+
 static __fi void ModRM( uint mod, uint reg, uint rm )
 {
-	xWrite8( (mod << 6) | (reg << 3) | rm );
+	xWrite8( (mod << 6) | ((reg & 7) << 3) | (rm & 7) );
 }
 
 static __fi void SibSB( u32 ss, u32 index, u32 base )
 {
-	xWrite8( (ss << 6) | (index << 3) | base );
+	xWrite8( (ss << 6) | ((index & 7) << 3) | (base & 7) );
 }
 
 void EmitSibMagic( uint regfield, const void* address )
@@ -241,13 +244,17 @@ void EmitSibMagic( uint regfield, const void* address )
 //
 __emitinline void xOpWrite0F( u8 prefix, u16 opcode, int instId, const xIndirectVoid& sib )
 {
-	SimdPrefix( prefix, opcode );
+	if( prefix != 0 ) xWrite8( prefix );
+	EmitRex( instId, sib );
+	SimdPrefix( 0, opcode );
 	EmitSibMagic( instId, sib );
 }
 
 __emitinline void xOpWrite0F( u8 prefix, u16 opcode, int instId, const void* data )
 {
-	SimdPrefix( prefix, opcode );
+	if( prefix != 0 ) xWrite8( prefix );
+	EmitRex( instId, data );
+	SimdPrefix( 0, opcode );
 	EmitSibMagic( instId, data );
 }
 
@@ -284,7 +291,7 @@ static __fi bool NeedsSibMagic( const xIndirectVoid& info )
 //
 void EmitSibMagic( uint regfield, const xIndirectVoid& info )
 {
-	pxAssertDev( regfield < 8, "Invalid x86 register identifier." );
+	pxAssertDev( regfield < 16, "Invalid x86 register identifier." );
 
 	int displacement_size = (info.Displacement == 0) ? 0 :
 		( ( info.IsByteSizeDisp() ) ? 1 : 2 );
@@ -305,8 +312,8 @@ void EmitSibMagic( uint regfield, const xIndirectVoid& info )
 		}
 		else
 		{
-			if( info.Index == ebp && displacement_size == 0 )
-				displacement_size = 1;		// forces [ebp] to be encoded as [ebp+0]!
+			if( (info.Index.Id & 7) == ebp.Id && displacement_size == 0 )
+				displacement_size = 1;		// forces [ebp] (and [r13]) to be encoded as [ebp+0]!
 
 			ModRM( displacement_size, regfield, info.Index.Id );
 		}
@@ -328,8 +335,8 @@ void EmitSibMagic( uint regfield, const xIndirectVoid& info )
 		}
 		else
 		{
-			if( info.Base == ebp && displacement_size == 0 )
-				displacement_size = 1;		// forces [ebp] to be encoded as [ebp+0]!
+			if( (info.Base.Id & 7) == ebp.Id && displacement_size == 0 )
+				displacement_size = 1;		// forces [ebp] (and [r13]) to be encoded as [ebp+0]!
 
 			ModRM( displacement_size, regfield, ModRm_UseSib );
 			SibSB( info.Scale, info.Index.Id, info.Base.Id );
@@ -349,12 +356,12 @@ void EmitSibMagic( uint regfield, const xIndirectVoid& info )
 // instructions taking a form of [reg,reg].
 void EmitSibMagic( uint reg1, const xRegisterBase& reg2 )
 {
-	xWrite8( (Mod_Direct << 6) | (reg1 << 3) | reg2.Id );
+	ModRM( Mod_Direct, reg1, reg2.Id );
 }
 
 void EmitSibMagic( const xRegisterBase& reg1, const xRegisterBase& reg2 )
 {
-	xWrite8( (Mod_Direct << 6) | (reg1.Id << 3) | reg2.Id );
+	ModRM( Mod_Direct, reg1.Id, reg2.Id );
 }
 
 void EmitSibMagic( const xRegisterBase& reg1, const void* src )
@@ -367,6 +374,69 @@ void EmitSibMagic( const xRegisterBase& reg1, const xIndirectVoid& sib )
 	EmitSibMagic( reg1.Id, sib );
 }
 
+// --------------------------------------------------------------------------------------
+//  EmitRex  -  REX prefix for x86-64 register extensions
+// --------------------------------------------------------------------------------------
+// Takes the same operands as EmitSibMagic and must be written after any legacy prefix
+// (0x66/0xf2/0xf3) and right before the opcode.  REX.R/X/B carry the 4th bit of the
+// ModRm reg, SIB index and ModRm rm / SIB base fields respectively.  REX.W (64-bit
+// operand size) is not generated yet, since there are no 64-bit register types.
+//
+// The R/X/B bits are computed in every build, so the 32-bit emitter runs the same code
+// on each instruction it writes.  32-bit builds have no REX prefix (0x40-0x4f are
+// inc/dec) though, so there a non-zero result is an error and nothing is written.
+//
+// This is groundwork only: no register type has an Id above 7 yet, and there is no 64-bit
+// build, recompiler port or dispatcher port using it.
+//
+static __fi void EmitRexBits( uint r, uint x, uint b )
+{
+	const uint rex = ((r & 8) >> 1) | ((x & 8) >> 2) | ((b & 8) >> 3);
+
+#ifdef __x86_64__
+	if( rex != 0 ) xWrite8( 0x40 | rex );
+#else
+	pxAssertDev( rex == 0, "x86-64 register used in a 32-bit build." );
+#endif
+}
+
+void EmitRex( uint regfield, const void* address )
+{
+	EmitRexBits( regfield, 0, 0 );
+}
+
+void EmitRex( uint regfield, const xIndirectVoid& info )
+{
+	// Mirrors EmitSibMagic: without a SIB the lone register sits in ModRm.rm.
+	const uint index = info.Index.IsEmpty() ? 0 : info.Index.Id;
+	const uint base  = info.Base.IsEmpty() ? 0 : info.Base.Id;
+
+	if( NeedsSibMagic( info ) )
+		EmitRexBits( regfield, index, base );
+	else
+		EmitRexBits( regfield, 0, index );
+}
+
+void EmitRex( uint reg1, const xRegisterBase& reg2 )
+{
+	EmitRexBits( reg1, 0, reg2.Id );
+}
+
+void EmitRex( const xRegisterBase& reg1, const xRegisterBase& reg2 )
+{
+	EmitRexBits( reg1.Id, 0, reg2.Id );
+}
+
+void EmitRex( const xRegisterBase& reg1, const void* src )
+{
+	EmitRexBits( reg1.Id, 0, 0 );
+}
+
+void EmitRex( const xRegisterBase& reg1, const xIndirectVoid& sib )
+{
+	EmitRex( reg1.Id, sib );
+}
+
 // --------------------------------------------------------------------------------------
 //  xSetPtr / xAlignPtr / xGetPtr / xAdvancePtr
 // --------------------------------------------------------------------------------------
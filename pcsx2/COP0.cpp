@@ -16,6 +16,7 @@
 
 #include "PrecompiledHeader.h"
 #include "Common.h"
+#include "Cache.h"
 
 u32 s_iLastCOP0Cycle = 0;
 u32 s_iLastPERFCycle[2] = { 0, 0 };
@@ -325,6 +326,7 @@ void WriteTLB(int i)
 	tlb[i].S = cpuRegs.CP0.n.EntryLo0&0x80000000;
 
 	MapTLB(i);
+	cacheUpdatePages();
 }
 
 namespace R5900 {
@@ -19,6 +19,11 @@
 #include "Cache.h"
 #include "vtlb.h"
 _cacheS pCache[64];
+__aligned16 u8 pCachePages[0x100000];
+
+// Page ranges currently set in pCachePages (two per TLB entry at most).
+static u32 s_cachedRanges[96][2];
+static int s_nCachedRanges = 0;
 
 #define DIRTY_FLAG 0x40
 #define VALID_FLAG 0x20
@@ -30,6 +35,34 @@ using namespace vtlb_private;
 
 
 
+static void cacheMarkRange(u32 start, u32 mask)
+{
+	u32 spage = start >> VTLB_PAGE_BITS;
+	u32 epage = (start + mask < start) ? 0xfffff : (start + mask) >> VTLB_PAGE_BITS;
+
+	memset(&pCachePages[spage], 1, epage - spage + 1);
+	s_cachedRanges[s_nCachedRanges][0] = spage;
+	s_cachedRanges[s_nCachedRanges][1] = epage;
+	s_nCachedRanges++;
+}
+
+// Replaces the per-access scan of the TLB: marks the pages covered by entries with
+// cache mode 3 (cached), using the same entries and ranges the scan used to.
+void cacheUpdatePages()
+{
+	for(int i = 0; i < s_nCachedRanges; i++)
+		memset(&pCachePages[s_cachedRanges[i][0]], 0, s_cachedRanges[i][1] - s_cachedRanges[i][0] + 1);
+	s_nCachedRanges = 0;
+
+	for(int i = 1; i < 48; i++)
+	{
+		if (((tlb[i].EntryLo1 & 0x38) >> 3) == 0x3)
+			cacheMarkRange(tlb[i].PFN1, tlb[i].PageMask);
+		if (((tlb[i].EntryLo0 & 0x38) >> 3) == 0x3)
+			cacheMarkRange(tlb[i].PFN0, tlb[i].PageMask);
+	}
+}
+
 int getFreeCache(u32 mem, int mode, int * way ) {
 	int number;
 	int i = (mem >> 6) & 0x3F;
@@ -39,6 +39,12 @@ struct _cacheS {
 
 extern _cacheS pCache[64];
 
+// One byte per 4k page of the address space, non-zero if a TLB entry maps the page as
+// cached.  Rebuilt by cacheUpdatePages whenever the TLB changes.
+extern u8 pCachePages[0x100000];
+
+void cacheUpdatePages();
+
 void writeCache8(u32 mem, u8 value);
 void writeCache16(u32 mem, u16 value);
 void writeCache32(u32 mem, u32 value);
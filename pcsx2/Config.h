@@ -228,7 +228,9 @@ struct Pcsx2Config
 				PreBlockCheckEE	:1,
 				PreBlockCheckIOP:1;
 			bool
-				EnableEECache   :1;
+				EnableEECache   :1,
+				EEDeferCompile  :1,
+				EERegLiveness   :1;
 		BITFIELD_END
 
 		RecompilerOptions();
@@ -397,6 +397,22 @@ static __fi void VSyncEnd(u32 sCycle)
 	if(EmuConfig.Trace.Enabled && EmuConfig.Trace.EE.m_EnableAll)
 		SysTrace.EE.Counters.Write( "    ================  EE COUNTER VSYNC END (frame: %d)  ================", g_FrameCount );
 
+	eeEventStatsFrame = eeEventStats;
+	memzero( eeEventStats );
+	eeBranchStatsFrame = eeBranchStats;
+	memzero( eeBranchStats );
+	eeJitStatsFrame = eeJitStats;
+	memzero( eeJitStats );
+
+	if(EmuConfig.Trace.Enabled && EmuConfig.Trace.EE.m_EnableAll)
+	{
+		SysTrace.EE.Counters.Write( "    event tests: %u, DMAC events: %u", eeEventStatsFrame.tests, eeEventStatsFrame.dispatched );
+		SysTrace.EE.Counters.Write( "    dispatches: %u, predicted jumps: %u hit, %u missed",
+			eeBranchStatsFrame.dispatched, eeBranchStatsFrame.hits, eeBranchStatsFrame.misses );
+		SysTrace.EE.Counters.Write( "    deferred compiles: %u queued, %u compiled, queue depth %u, %u instructions interpreted",
+			eeJitStatsFrame.queued, eeJitStatsFrame.compiled, eeJitStatsFrame.maxDepth, eeJitStatsFrame.interpreted );
+	}
+
 	g_FrameCount++;
 
 
@@ -118,6 +118,26 @@ void intSetBranch()
 	branch2 = /*cpuRegs.branch =*/ 1;
 }
 
+// Runs the EE code at cpuRegs.pc up to the end of the next branch (delay slot included)
+// and returns the number of instructions run.  Used by the recompiler for blocks it has
+// not compiled yet; the cycles of the branch codes not counted by doBranch are added here.
+u32 intExecuteBlock()
+{
+	u32 count = 0;
+
+	branch2 = 0;
+	while( !branch2 )
+	{
+		execI();
+		count++;
+	}
+
+	cpuRegs.cycle += cpuBlockCycles >> 3;
+	cpuBlockCycles &= (1<<3)-1;
+
+	return count;
+}
+
 ////////////////////////////////////////////////////////////////////
 // R5900 Branching Instructions!
 // These are the interpreter versions of the branch instructions.  Unlike other
@@ -853,9 +853,12 @@ void eeMemoryReserve::Release()
 // protection causes an *exception* to be raised (signal in Linux), which is handled by
 // unprotecting the page and switching the recompiled block to "manual" protection.
 //
-// Manual protection uses a simple brute-force memcmp of the recompiled code to the code
-// currently in RAM for *each time* the block is executed.  Fool-proof, but slow, which
-// is why we default to using the exception-based protection scheme described above.
+// Manual protection compares the code of a block with the copy it was recompiled from each
+// time the block is executed.  Fool-proof, but slow, which is why we default to using the
+// exception-based protection scheme described above.  A write fault does not clear the whole
+// page: the blocks overlapping the 128 byte line being written are discarded, the others are
+// kept and from then on enter through a check of their code (see recSelfCheckPage), so only
+// the blocks whose code really changes get recompiled.
 //
 // Why manual blocks?  Because many games contain code and data in the same 4k page, so
 // we *cannot* automatically recompile and reprotect pages, lest we end up recompiling and
@@ -871,13 +874,6 @@ void eeMemoryReserve::Release()
 // code below.
 //
 
-enum vtlb_ProtectionMode
-{
-	ProtMode_None = 0,		// page is 'unaccounted' -- neither protected nor unprotected
-	ProtMode_Write,			// page is under write protection (exception handler)
-	ProtMode_Manual			// page is under manual protection (self-checked at execution)
-};
-
 struct vtlb_PageProtectionInfo
 {
 	// Ram De-mapping -- used to convert fully translated/mapped offsets (which reside with
@@ -888,10 +884,15 @@ struct vtlb_PageProtectionInfo
 	u32 ReverseRamMap;
 
 	vtlb_ProtectionMode Mode;
+
+	// one bit for each 128 byte line of the page that holds recompiled code
+	u32 CodeLines;
 };
 
 static __aligned16 vtlb_PageProtectionInfo m_PageProtectInfo[Ps2MemSize::MainRam >> 12];
 
+mmap_SmcStats mmap_smcStats;
+
 
 // returns:
 //  -1 - unchecked block (resides in ROM, thus is integrity is constant)
@@ -915,6 +916,23 @@ int mmap_GetRamPageInfo( u32 paddr )
 	return ( m_PageProtectInfo[rampage].Mode == ProtMode_Manual ) ? 1 : 0;
 }
 
+// paddr - physically mapped PS2 address of recompiled code, the range must not cross a page.
+void mmap_MarkCodeRange( u32 paddr, u32 size )
+{
+	pxAssert( eeMem && size > 0 );
+
+	uptr ptr = (uptr)PSM( paddr & ~0xfff );
+	uptr rampage = ptr - (uptr)eeMem->Main;
+
+	if (rampage >= Ps2MemSize::MainRam)
+		return;
+
+	uint first = (paddr & 0xfff) >> 7;
+	uint last = ((paddr & 0xfff) + size - 1) >> 7;
+
+	m_PageProtectInfo[rampage >> 12].CodeLines |= (u32)((2ULL << last) - (1ULL << first));
+}
+
 // paddr - physically mapped PS2 address
 void mmap_MarkCountedRamPage( u32 paddr )
 {
@@ -943,8 +961,8 @@ void mmap_MarkCountedRamPage( u32 paddr )
 }
 
 // offset - offset of address relative to psM.
-// All recompiled blocks belonging to the page are cleared, and any new blocks recompiled
-// from code residing in this page will use manual protection.
+// The page is switched to manual protection.  Its recompiled blocks are not all cleared: the
+// ones in the 128 byte line being written go, the others check their own code from now on.
 static __fi void mmap_ClearCpuBlock( uint offset )
 {
 	pxAssert( eeMem );
@@ -956,9 +974,20 @@ static __fi void mmap_ClearCpuBlock( uint offset )
 	pxAssertMsg( m_PageProtectInfo[rampage].Mode != ProtMode_Manual,
 		"Attempted to clear a block that is already under manual protection." );
 
+	mmap_smcStats.faults++;
+
+	int line = (offset & 0xfff) >> 7;
+
+	if( !(m_PageProtectInfo[rampage].CodeLines & (1 << line)) )
+	{
+		mmap_smcStats.dataFaults++;
+		line = -1;
+	}
+
 	HostSys::MemProtect( &eeMem->Main[rampage<<12], __pagesize, PageAccess_ReadWrite() );
 	m_PageProtectInfo[rampage].Mode = ProtMode_Manual;
-	Cpu->Clear( m_PageProtectInfo[rampage].ReverseRamMap, 0x400 );
+
+	recSelfCheckPage( m_PageProtectInfo[rampage].ReverseRamMap, line );
 }
 
 void mmap_PageFaultHandler::OnPageFaultEvent( const PageFaultInfo& info, bool& handled )
@@ -116,10 +116,37 @@ extern void memBindConditionalHandlers();
 
 extern void memMapVUmicro();
 
+enum vtlb_ProtectionMode
+{
+	ProtMode_None = 0,		// page is 'unaccounted' -- neither protected nor unprotected
+	ProtMode_Write,			// page is under write protection (exception handler)
+	ProtMode_Manual			// page is under manual protection (self-checked at execution)
+};
+
+// Self-modifying code tracking, filled by the page fault handler and the EE recompiler.
+struct mmap_SmcStats
+{
+	u32 faults;			// write faults on pages holding recompiled code
+	u32 dataFaults;		// of those, writes into 128 byte lines without any code
+	u32 invalidated;	// blocks discarded because their code changed
+	u32 reprotected;	// pages switched back to write protection
+	u32 blocksKept;		// blocks that survived a fault and did not need recompiling
+	u64 ticksSaved;		// estimated recompile time of the kept blocks
+	u32 checkCalls;		// code checks of kept blocks (a call and a memcmp each)
+	u64 checkedWords;	// code words compared inline by the blocks of manual pages
+};
+
+extern mmap_SmcStats mmap_smcStats;
+
 extern int mmap_GetRamPageInfo( u32 paddr );
 extern void mmap_MarkCountedRamPage( u32 paddr );
+extern void mmap_MarkCodeRange( u32 paddr, u32 size );
 extern void mmap_ResetBlockTracking();
 
+// EE recompiler: the page of paddr lost its write protection, line is the 128 byte line of the
+// page being written or -1 if it holds no code.
+extern void recSelfCheckPage( u32 paddr, int line );
+
 #define memRead8 vtlb_memRead<mem8_t>
 #define memRead16 vtlb_memRead<mem16_t>
 #define memRead32 vtlb_memRead<mem32_t>
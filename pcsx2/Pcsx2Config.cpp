@@ -147,6 +147,8 @@ void Pcsx2Config::RecompilerOptions::LoadSave( IniInterface& ini )
 	IniBitBool( EnableEE );
 	IniBitBool( EnableIOP );
 	IniBitBool( EnableEECache );
+	IniBitBool( EEDeferCompile );
+	IniBitBool( EERegLiveness );
 	IniBitBool( EnableVU0 );
 	IniBitBool( EnableVU1 );
 
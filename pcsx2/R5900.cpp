@@ -21,6 +21,7 @@
 #include "R3000A.h"
 #include "VUmicro.h"
 #include "COP0.h"
+#include "Cache.h"
 #include "MTVU.h"
 
 #include "System/SysThreads.h"
@@ -64,6 +65,7 @@ void cpuReset()
 	memzero(cpuRegs);
 	memzero(fpuRegs);
 	memzero(tlb);
+	cacheUpdatePages();
 
 	cpuRegs.pc				= 0xbfc00000; //set pc reg to stack
 	cpuRegs.CP0.n.Config	= 0x440;
@@ -75,6 +77,7 @@ void cpuReset()
 	g_nextEventCycle = cpuRegs.cycle + 4;
 	EEsCycle = 0;
 	EEoCycle = cpuRegs.cycle;
+	cpuResetEvents();
 
 	hwReset();
 	rcntInit();
@@ -252,23 +255,155 @@ __fi void cpuSetEvent()
 	g_nextEventCycle = cpuRegs.cycle;
 }
 
-__fi void cpuClearInt( uint i )
+// --------------------------------------------------------------------------------------
+//  DMAC event queue
+// --------------------------------------------------------------------------------------
+// The channel interrupts raised by CPU_INT are kept in a binary min-heap keyed by the absolute
+// cycle they are due, so the event test only has to look at its head instead of testing every
+// channel.  cpuRegs.interrupt/sCycle/eCycle remain the saved state; some DMA code clears the
+// bits or stretches eCycle directly, so the head is always checked against them.
+//
+// Only the DMAC channels are queued here.  The counters (hsync/vsync included) and the IOP
+// sync keep their own single deadline and are still folded into g_nextEventCycle directly.
+
+static const uint DMAC_EVENTS = DMAC_MFIFO_GIF + 1;
+
+static void (* const s_eventHandlers[DMAC_EVENTS])() =
 {
-	jASSUME( i < 32 );
-	cpuRegs.interrupt &= ~(1 << i);
+	vif0Interrupt, vif1Interrupt, gifInterrupt, ipu0Interrupt, ipu1Interrupt, EEsif0Interrupt,
+	EEsif1Interrupt, NULL, SPRFROMinterrupt, SPRTOinterrupt, vifMFIFOInterrupt, gifMFIFOInterrupt
+};
+
+// Events due at the same time are handled in the order the channels were always tested in.
+static const u8 s_eventOrder[DMAC_EVENTS] =
+{
+	DMAC_VIF1, DMAC_GIF, DMAC_SIF0, DMAC_SIF1, DMAC_VIF0, DMAC_FROM_IPU,
+	DMAC_TO_IPU, DMAC_FROM_SPR, DMAC_TO_SPR, DMAC_MFIFO_VIF, DMAC_MFIFO_GIF, DMAC_SIF2
+};
+
+static u8 s_eventPriority[DMAC_EVENTS];
+static u8 s_eventHeap[DMAC_EVENTS];
+static s8 s_eventPos[DMAC_EVENTS];		// index of the channel in the heap, -1 if not queued
+static u32 s_eventCycle[DMAC_EVENTS];	// key of the channel in the heap
+static uint s_eventCount = 0;
+
+EEEventStats eeEventStats;
+EEEventStats eeEventStatsFrame;
+EEBranchStats eeBranchStats;
+EEBranchStats eeBranchStatsFrame;
+EEJitStats eeJitStats;
+EEJitStats eeJitStatsFrame;
+
+static __fi bool eventBefore( uint a, uint b )
+{
+	s32 diff = (s32)(s_eventCycle[a] - s_eventCycle[b]);
+
+	return diff < 0 || (diff == 0 && s_eventPriority[a] < s_eventPriority[b]);
+}
+
+static __fi void eventSet( uint pos, uint n )
+{
+	s_eventHeap[pos] = n;
+	s_eventPos[n] = pos;
 }
 
-static __fi void TESTINT( u8 n, void (*callback)() )
+static void eventSiftUp( uint pos )
 {
-	if( !(cpuRegs.interrupt & (1 << n)) ) return;
+	uint n = s_eventHeap[pos];
 
-	if( cpuTestCycle( cpuRegs.sCycle[n], cpuRegs.eCycle[n] ) )
+	while( pos > 0 )
 	{
-		cpuClearInt( n );
-		callback();
+		uint parent = (pos - 1) / 2;
+
+		if( !eventBefore( n, s_eventHeap[parent] ) ) break;
+
+		eventSet( pos, s_eventHeap[parent] );
+		pos = parent;
 	}
-	else
-		cpuSetNextEvent( cpuRegs.sCycle[n], cpuRegs.eCycle[n] );
+
+	eventSet( pos, n );
+}
+
+static void eventSiftDown( uint pos )
+{
+	uint n = s_eventHeap[pos];
+
+	for(;;)
+	{
+		uint child = pos * 2 + 1;
+
+		if( child >= s_eventCount ) break;
+		if( child + 1 < s_eventCount && eventBefore( s_eventHeap[child + 1], s_eventHeap[child] ) ) child++;
+		if( !eventBefore( s_eventHeap[child], n ) ) break;
+
+		eventSet( pos, s_eventHeap[child] );
+		pos = child;
+	}
+
+	eventSet( pos, n );
+}
+
+static void eventQueue( uint n )
+{
+	s_eventCycle[n] = cpuRegs.sCycle[n] + cpuRegs.eCycle[n];
+
+	if( s_eventPos[n] < 0 )
+	{
+		eventSet( s_eventCount++, n );
+	}
+
+	eventSiftUp( s_eventPos[n] );
+	eventSiftDown( s_eventPos[n] );
+}
+
+static void eventRemove( uint n )
+{
+	int pos = s_eventPos[n];
+
+	if( pos < 0 ) return;
+
+	s_eventPos[n] = -1;
+
+	if( (uint)pos == --s_eventCount ) return;
+
+	uint moved = s_eventHeap[s_eventCount];
+
+	eventSet( pos, moved );
+	eventSiftUp( pos );
+	eventSiftDown( s_eventPos[moved] );
+}
+
+// Rebuilds the queue from cpuRegs, after a reset or loading a savestate.
+void cpuResetEvents()
+{
+	for( uint i = 0; i < DMAC_EVENTS; i++ )
+	{
+		s_eventPriority[s_eventOrder[i]] = i;
+		s_eventPos[i] = -1;
+	}
+
+	s_eventCount = 0;
+
+	for( uint n = 0; n < DMAC_EVENTS; n++ )
+	{
+		if( s_eventHandlers[n] && (cpuRegs.interrupt & (1 << n)) )
+			eventQueue( n );
+	}
+
+	memzero( eeEventStats );
+	memzero( eeEventStatsFrame );
+	memzero( eeBranchStats );
+	memzero( eeBranchStatsFrame );
+	memzero( eeJitStats );
+	memzero( eeJitStatsFrame );
+}
+
+__fi void cpuClearInt( uint i )
+{
+	jASSUME( i < 32 );
+	cpuRegs.interrupt &= ~(1 << i);
+
+	if( i < DMAC_EVENTS ) eventRemove( i );
 }
 
 // [TODO] move this function to LegacyDmac.cpp, and remove most of the DMAC-related headers from
@@ -283,27 +418,60 @@ static __fi void _cpuTestInterrupts()
 	/* These are 'pcsx2 interrupts', they handle asynchronous stuff
 	   that depends on the cycle timings */
 
-	TESTINT(DMAC_VIF1,		vif1Interrupt);	
-	TESTINT(DMAC_GIF,		gifInterrupt);
-	TESTINT(DMAC_SIF0,		EEsif0Interrupt);
-	TESTINT(DMAC_SIF1,		EEsif1Interrupt);
-	
-	// Profile-guided Optimization (sorta)
-	// The following ints are rarely called.  Encasing them in a conditional
-	// as follows helps speed up most games.
+	// Take everything due off the queue before running any handler, the handlers raise new events.
+	//
+	// The head is checked against cpuRegs lazily instead of updating the heap at every direct
+	// write, which only ever makes an entry stale in the safe direction:
+	//  * Vif.cpp stops VIF0/VIF1 with "cpuRegs.interrupt &= ~", the entry stays queued and is
+	//    dropped here once it reaches the head.  Until then it can only cause one early test.
+	//  * IPUdma.cpp parks the IPU1 channel with "eCycle[4] = 0x9999", which moves it later; the
+	//    old key is earlier, so the entry reaches the head no later than it should and is re-keyed
+	//    here.  IPU_Fifo.cpp restarts it with CPU_INT, which re-keys it as usual.
+	// A direct write that brought an event *earlier* would be missed, so use CPU_INT for those.
+
+	uint due = 0;
+
+	while( s_eventCount > 0 )
+	{
+		uint n = s_eventHeap[0];
 
-	if( cpuRegs.interrupt & 0xF19 ) // Bits 0 3 4 8 9 10 11 ( 111100011001 )
+		if( !(cpuRegs.interrupt & (1 << n)) )
+		{
+			eventRemove( n ); // cleared without cpuClearInt
+		}
+		else if( s_eventCycle[n] != cpuRegs.sCycle[n] + cpuRegs.eCycle[n] )
+		{
+			eventQueue( n ); // eCycle was changed without CPU_INT
+		}
+		else if( cpuTestCycle( cpuRegs.sCycle[n], cpuRegs.eCycle[n] ) )
+		{
+			eventRemove( n );
+			due |= 1 << n;
+		}
+		else break;
+	}
+
+	for( uint i = 0; due != 0; i++ )
 	{
-		TESTINT(DMAC_VIF0,		vif0Interrupt);
+		uint n = s_eventOrder[i];
+
+		if( !(due & (1 << n)) ) continue;
 
-		TESTINT(DMAC_FROM_IPU,	ipu0Interrupt);
-		TESTINT(DMAC_TO_IPU,	ipu1Interrupt);
+		due &= ~(1 << n);
 
-		TESTINT(DMAC_FROM_SPR,	SPRFROMinterrupt);
-		TESTINT(DMAC_TO_SPR,	SPRTOinterrupt);
+		// an earlier handler may have stopped the channel or raised it again
+		if( !(cpuRegs.interrupt & (1 << n)) || s_eventPos[n] >= 0 ) continue;
 
-		TESTINT(DMAC_MFIFO_VIF, vifMFIFOInterrupt);
-		TESTINT(DMAC_MFIFO_GIF, gifMFIFOInterrupt);
+		cpuClearInt( n );
+		eeEventStats.dispatched++;
+		s_eventHandlers[n]();
+	}
+
+	if( s_eventCount > 0 )
+	{
+		uint n = s_eventHeap[0];
+
+		cpuSetNextEvent( cpuRegs.sCycle[n], cpuRegs.eCycle[n] );
 	}
 }
 
@@ -357,6 +525,7 @@ __fi void _cpuEventTest_Shared()
 {
 	ScopedBool etest(eeEventTestIsActive);
 	g_nextEventCycle = cpuRegs.cycle + eeWaitCycles;
+	eeEventStats.tests++;
 
 	// ---- INTC / DMAC (CPU-level Exceptions) -----------------
 	// Done first because exceptions raised during event tests need to be postponed a few
@@ -507,6 +676,8 @@ __fi void CPU_INT( EE_EventType n, s32 ecycle)
 	cpuRegs.sCycle[n] = cpuRegs.cycle;
 	cpuRegs.eCycle[n] = ecycle;
 
+	if( n < DMAC_EVENTS && s_eventHandlers[n] ) eventQueue( n );
+
 	// Interrupt is happening soon: make sure both EE and IOP are aware.
 
 	if( ecycle <= 28 && iopCycleEE > 0 )
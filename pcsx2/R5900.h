@@ -255,6 +255,9 @@ void intSetBranch();
 // parts of the Recs (namely COP0's branch codes and stuff).
 void __fastcall intDoBranch(u32 target);
 
+// Interprets up to the next branch, for code the recompiler hasn't compiled yet.
+u32 intExecuteBlock();
+
 // modules loaded at hardcoded addresses by the kernel
 const u32 EEKERNEL_START	= 0;
 const u32 EENULL_START		= 0x81FC0;
@@ -421,6 +424,40 @@ extern void cpuTlbMissR(u32 addr, u32 bd);
 extern void cpuTlbMissW(u32 addr, u32 bd);
 extern void cpuTestHwInts();
 extern void cpuClearInt(uint n);
+extern void cpuResetEvents();
+
+// Event test activity, eeEventStatsFrame holds the counts of the last frame.
+struct EEEventStats
+{
+	u32 tests;			// _cpuEventTest_Shared calls
+	u32 dispatched;		// DMAC events handled
+};
+
+extern EEEventStats eeEventStats;
+extern EEEventStats eeEventStatsFrame;
+
+// Recompiler dispatch activity, eeBranchStatsFrame holds the counts of the last frame.
+struct EEBranchStats
+{
+	u32 dispatched;		// DispatcherReg entries
+	u32 hits;			// JR/JALR targets guessed right (devbuilds only)
+	u32 misses;			// JR/JALR targets guessed wrong
+};
+
+extern EEBranchStats eeBranchStats;
+extern EEBranchStats eeBranchStatsFrame;
+
+// Deferred recompiler work (EEDeferCompile), eeJitStatsFrame holds the counts of the last frame.
+struct EEJitStats
+{
+	u32 queued;			// new blocks queued for compiling
+	u32 compiled;		// queued blocks compiled
+	u32 interpreted;	// instructions run by the interpreter until then
+	u32 maxDepth;		// deepest the compile queue got
+};
+
+extern EEJitStats eeJitStats;
+extern EEJitStats eeJitStatsFrame;
 
 extern void cpuSetNextEvent( u32 startCycle, s32 delta );
 extern void cpuSetNextEventDelta( s32 delta );
@@ -43,6 +43,8 @@ static void PostLoadPrep()
 	memzero(pCache);
 //	WriteCP0Status(cpuRegs.CP0.n.Status.val);
 	for(int i=0; i<48; i++) MapTLB(i);
+	cacheUpdatePages();
+	cpuResetEvents();
 
 	UpdateVSyncRate();
 }
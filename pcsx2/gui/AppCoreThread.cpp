@@ -246,6 +246,13 @@ static int loadGameSettings(Pcsx2Config& dest, const Game_Data& game, bool verbo
 		gf++;
 	}
 
+	if (game.keyExists("eeCache")) {
+		bool enableIt = game.getBool("eeCache");
+		if(verbose) Console.WriteLn("(GameDB) %s EE data cache emulation", enableIt ? "Enabling" : "Disabling");
+		dest.Cpu.Recompiler.EnableEECache = enableIt;
+		gf++;
+	}
+
 	for( GamefixId id=GamefixId_FIRST; id<pxEnumEnd; ++id )
 	{
 		wxString key( EnumToString(id) );
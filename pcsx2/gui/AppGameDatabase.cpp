@@ -17,6 +17,19 @@
 #include "App.h"
 #include "AppGameDatabase.h"
 #include <wx/stdpaths.h>
+#include <wx/ffile.h>
+
+#include <algorithm>
+#include <map>
+
+#ifdef __WXMSW__
+#	include <wx/msw/wrapwin.h>		// file mapping API
+#else
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
 
 class DBLoaderHelper
 {
@@ -146,10 +159,534 @@ void DBLoaderHelper::ReadGames()
 	}
 }
 
+
+// --------------------------------------------------------------------------------------
+//  GameIndex.cache format
+// --------------------------------------------------------------------------------------
+// The compiled database is position-independent so that it can be mapped straight into
+// memory and used in place.  Every string (serials, keys and values alike) is interned once
+// as UTF-8 into a single blob and referenced by index; games are stored in their original
+// file order (so the text database can be regenerated faithfully) and a second table holds
+// game indexes sorted case-insensitively by serial, for binary-search lookups.
+//
+// The cache is only ever read back by the build that wrote it, so the tables are stored in
+// native byte order.  Bump the version whenever the layout changes.
+
+static const char GameDbCacheMagic[8]	= { 'P','2','G','D','B','C','H','\0' };
+static const u32 GameDbCacheVersion		= 1;
+
+struct GameDbCacheHeader
+{
+	char	Magic[8];
+	u64		SourceSize;			// size of the .dbf this cache was compiled from
+	s64		SourceTime;			// modification time of the .dbf this cache was compiled from
+
+	u32		Version;
+	u32		FileSize;			// size of the whole cache, used to detect truncated files
+
+	u32		HeaderStr;			// string index of the database's comment header
+	u32		StringCount;
+	u32		GameCount;
+	u32		PairCount;
+	u32		IndexCount;			// may be less than GameCount if the .dbf has duplicate serials
+
+	u32		StringTableOfs;
+	u32		GameTableOfs;
+	u32		PairTableOfs;
+	u32		IndexTableOfs;
+	u32		StringDataOfs;
+	u32		StringDataSize;
+};
+
+struct GameDbCacheString
+{
+	u32		Offset;				// offset into the string blob
+	u32		Length;				// length in bytes (UTF-8), not including the null terminator
+};
+
+struct GameDbCacheGame
+{
+	u32		Id;					// string index of the serial
+	u32		FirstPair;
+	u32		PairCount;
+};
+
+struct GameDbCachePair
+{
+	u32		Key;
+	u32		Value;
+};
+
+// Serials are plain ASCII, so a simple ASCII fold is sufficient (and matches the case-folding
+// done by Game_Data::CompareId for every serial in the official database).
+static int CompareNoCaseAscii( const char* a, u32 alen, const char* b, u32 blen )
+{
+	const u32 len = std::min( alen, blen );
+	for( u32 i=0; i<len; ++i )
+	{
+		int ca = (u8)a[i], cb = (u8)b[i];
+		if( ca >= 'A' && ca <= 'Z' ) ca += 'a' - 'A';
+		if( cb >= 'A' && cb <= 'Z' ) cb += 'a' - 'A';
+		if( ca != cb ) return ca - cb;
+	}
+	return (int)alen - (int)blen;
+}
+
+// --------------------------------------------------------------------------------------
+//  GameDatabaseCache
+// --------------------------------------------------------------------------------------
+// Read-only view of a mapped GameIndex.cache.
+//
+class GameDatabaseCache
+{
+	DeclareNoncopyableObject( GameDatabaseCache );
+
+protected:
+	const u8*					m_base;
+	size_t						m_size;
+
+	const GameDbCacheHeader*	m_header;
+	const GameDbCacheString*	m_strings;
+	const GameDbCacheGame*		m_games;
+	const GameDbCachePair*		m_pairs;
+	const u32*					m_index;
+	const char*					m_data;
+
+public:
+	GameDatabaseCache();
+	virtual ~GameDatabaseCache() throw();
+
+	bool Open( const wxString& cachefile );
+	void Close();
+
+	bool IsCurrent( u64 srcSize, s64 srcTime ) const;
+	bool Find( Game_Data& dest, const wxString& id ) const;
+	void GetGame( Game_Data& dest, uint gameidx ) const;
+
+	uint GetGameCount() const	{ return m_header ? m_header->GameCount : 0; }
+	uint GetIndexCount() const	{ return m_header ? m_header->IndexCount : 0; }
+	size_t GetSize() const		{ return m_size; }
+	wxString GetHeader() const	{ return m_header ? GetString( m_header->HeaderStr ) : wxString(); }
+
+protected:
+	bool Validate() const;
+	wxString GetString( u32 stridx ) const;
+	int CompareId( u32 gameidx, const char* id, u32 idlen ) const;
+};
+
+GameDatabaseCache::GameDatabaseCache()
+{
+	m_base		= NULL;
+	m_size		= 0;
+	m_header	= NULL;
+	m_strings	= NULL;
+	m_games		= NULL;
+	m_pairs		= NULL;
+	m_index		= NULL;
+	m_data		= NULL;
+}
+
+GameDatabaseCache::~GameDatabaseCache() throw()
+{
+	Close();
+}
+
+bool GameDatabaseCache::Open( const wxString& cachefile )
+{
+	Close();
+
+#ifdef __WXMSW__
+	HANDLE file = CreateFileW( cachefile.wc_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if( file == INVALID_HANDLE_VALUE ) return false;
+
+	const DWORD size = GetFileSize( file, NULL );
+	HANDLE mapping = (size >= sizeof(GameDbCacheHeader) && size != INVALID_FILE_SIZE)
+		? CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL ) : NULL;
+	CloseHandle( file );
+	if( !mapping ) return false;
+
+	// The view keeps the mapping object alive, so the handle can be released right away.
+	void* ptr = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( mapping );
+	if( !ptr ) return false;
+#else
+	int fd = open( cachefile.ToUTF8(), O_RDONLY );
+	if( fd < 0 ) return false;
+
+	struct stat st;
+	if( (fstat( fd, &st ) != 0) || (st.st_size < (off_t)sizeof(GameDbCacheHeader)) )
+	{
+		close( fd );
+		return false;
+	}
+
+	const size_t size = st.st_size;
+	void* ptr = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if( ptr == MAP_FAILED ) return false;
+#endif
+
+	m_base		= (const u8*)ptr;
+	m_size		= size;
+	m_header	= (const GameDbCacheHeader*)m_base;
+
+	if( !Validate() )
+	{
+		Close();
+		return false;
+	}
+
+	m_strings	= (const GameDbCacheString*)(m_base + m_header->StringTableOfs);
+	m_games		= (const GameDbCacheGame*)	(m_base + m_header->GameTableOfs);
+	m_pairs		= (const GameDbCachePair*)	(m_base + m_header->PairTableOfs);
+	m_index		= (const u32*)				(m_base + m_header->IndexTableOfs);
+	m_data		= (const char*)				(m_base + m_header->StringDataOfs);
+
+	return true;
+}
+
+void GameDatabaseCache::Close()
+{
+	if( m_base )
+	{
+#ifdef __WXMSW__
+		UnmapViewOfFile( (void*)m_base );
+#else
+		munmap( (void*)m_base, m_size );
+#endif
+	}
+
+	m_base		= NULL;
+	m_size		= 0;
+	m_header	= NULL;
+	m_strings	= NULL;
+	m_games		= NULL;
+	m_pairs		= NULL;
+	m_index		= NULL;
+	m_data		= NULL;
+}
+
+// Checks the header and the extents of every table.  Individual string/pair references are
+// range-checked on access instead, which keeps opening the cache from touching every page.
+bool GameDatabaseCache::Validate() const
+{
+	const GameDbCacheHeader& hdr( *m_header );
+
+	if( memcmp( hdr.Magic, GameDbCacheMagic, sizeof(GameDbCacheMagic) ) != 0 ) return false;
+	if( hdr.Version != GameDbCacheVersion ) return false;
+	if( hdr.FileSize != m_size ) return false;
+	if( hdr.IndexCount > hdr.GameCount ) return false;
+
+	const u64 size = m_size;
+	if( (u64)hdr.StringTableOfs	+ (u64)hdr.StringCount	* sizeof(GameDbCacheString)	> size ) return false;
+	if( (u64)hdr.GameTableOfs	+ (u64)hdr.GameCount	* sizeof(GameDbCacheGame)	> size ) return false;
+	if( (u64)hdr.PairTableOfs	+ (u64)hdr.PairCount	* sizeof(GameDbCachePair)	> size ) return false;
+	if( (u64)hdr.IndexTableOfs	+ (u64)hdr.IndexCount	* sizeof(u32)				> size ) return false;
+	if( (u64)hdr.StringDataOfs	+ (u64)hdr.StringDataSize							> size ) return false;
+
+	return true;
+}
+
+bool GameDatabaseCache::IsCurrent( u64 srcSize, s64 srcTime ) const
+{
+	return m_header && (m_header->SourceSize == srcSize) && (m_header->SourceTime == srcTime);
+}
+
+wxString GameDatabaseCache::GetString( u32 stridx ) const
+{
+	if( stridx >= m_header->StringCount ) return wxString();
+
+	const GameDbCacheString& str( m_strings[stridx] );
+	if( (u64)str.Offset + str.Length > m_header->StringDataSize ) return wxString();
+
+	return wxString( m_data + str.Offset, wxConvUTF8, str.Length );
+}
+
+int GameDatabaseCache::CompareId( u32 gameidx, const char* id, u32 idlen ) const
+{
+	const u32 stridx = (gameidx < m_header->GameCount) ? m_games[gameidx].Id : m_header->StringCount;
+	if( stridx >= m_header->StringCount ) return -1;
+
+	const GameDbCacheString& str( m_strings[stridx] );
+	if( (u64)str.Offset + str.Length > m_header->StringDataSize ) return -1;
+
+	return CompareNoCaseAscii( m_data + str.Offset, str.Length, id, idlen );
+}
+
+void GameDatabaseCache::GetGame( Game_Data& dest, uint gameidx ) const
+{
+	dest.clear();
+	if( gameidx >= m_header->GameCount ) return;
+
+	const GameDbCacheGame& game( m_games[gameidx] );
+	if( (u64)game.FirstPair + game.PairCount > m_header->PairCount ) return;
+
+	dest.id = GetString( game.Id );
+	dest.kList.reserve( game.PairCount );
+
+	for( u32 i=0; i<game.PairCount; ++i )
+	{
+		const GameDbCachePair& pair( m_pairs[game.FirstPair + i] );
+		dest.kList.push_back( key_pair( GetString(pair.Key), GetString(pair.Value) ) );
+	}
+}
+
+bool GameDatabaseCache::Find( Game_Data& dest, const wxString& id ) const
+{
+	if( m_header && !id.IsEmpty() )
+	{
+		pxToUTF8 utf8( id );
+		const char* key = utf8;
+		const u32 keylen = utf8.Length();
+
+		uint lo = 0, hi = m_header->IndexCount;
+		while( lo < hi )
+		{
+			const uint mid = (lo + hi) / 2;
+			const int cmp = CompareId( m_index[mid], key, keylen );
+
+			if( cmp < 0 )		lo = mid + 1;
+			else if( cmp > 0 )	hi = mid;
+			else
+			{
+				GetGame( dest, m_index[mid] );
+				return true;
+			}
+		}
+	}
+
+	dest.clear();
+	return false;
+}
+
+// --------------------------------------------------------------------------------------
+//  GameDbCacheWriter
+// --------------------------------------------------------------------------------------
+// Flattens parsed Game_Data into the cache layout described above.
+//
+class GameDbCacheWriter
+{
+	DeclareNoncopyableObject( GameDbCacheWriter );
+
+public:
+	std::vector<GameDbCacheString>	m_strings;
+	std::vector<GameDbCacheGame>	m_games;
+	std::vector<GameDbCachePair>	m_pairs;
+	std::vector<u32>				m_index;
+	std::string						m_data;
+
+protected:
+	std::map<std::string, u32>		m_interned;
+
+public:
+	GameDbCacheWriter() {}
+
+	u32 Intern( const wxString& src );
+	void AddGame( const Game_Data& game );
+	void BuildIndex();
+	bool Write( const wxString& file, const wxString& header, u64 srcSize, s64 srcTime );
+
+	int CompareGames( u32 g1, u32 g2 ) const
+	{
+		const GameDbCacheString& s1( m_strings[m_games[g1].Id] );
+		const GameDbCacheString& s2( m_strings[m_games[g2].Id] );
+		return CompareNoCaseAscii( &m_data[s1.Offset], s1.Length, &m_data[s2.Offset], s2.Length );
+	}
+};
+
+struct GameDbCacheIndexSort
+{
+	const GameDbCacheWriter& writer;
+
+	GameDbCacheIndexSort( const GameDbCacheWriter& _writer ) : writer( _writer ) {}
+
+	bool operator()( u32 g1, u32 g2 ) const
+	{
+		return writer.CompareGames( g1, g2 ) < 0;
+	}
+};
+
+u32 GameDbCacheWriter::Intern( const wxString& src )
+{
+	const std::string utf8( src.ToUTF8() );
+
+	std::map<std::string, u32>::const_iterator it( m_interned.find( utf8 ) );
+	if( it != m_interned.end() ) return it->second;
+
+	GameDbCacheString str;
+	str.Offset = m_data.length();
+	str.Length = utf8.length();
+
+	m_data.append( utf8 );
+	m_data.push_back( '\0' );
+
+	const u32 stridx = m_strings.size();
+	m_strings.push_back( str );
+	m_interned[utf8] = stridx;
+	return stridx;
+}
+
+void GameDbCacheWriter::AddGame( const Game_Data& game )
+{
+	GameDbCacheGame entry;
+	entry.Id		= Intern( game.id );
+	entry.FirstPair	= m_pairs.size();
+	entry.PairCount	= game.kList.size();
+
+	KeyPairArray::const_iterator i( game.kList.begin() );
+	for( ; i != game.kList.end(); ++i )
+	{
+		GameDbCachePair pair;
+		pair.Key	= Intern( i->key );
+		pair.Value	= Intern( i->value );
+		m_pairs.push_back( pair );
+	}
+
+	m_games.push_back( entry );
+}
+
+// When the .dbf lists a serial more than once the loader keeps the last entry, so the index
+// does the same: a stable sort keeps duplicates in file order, and the last of each run wins.
+void GameDbCacheWriter::BuildIndex()
+{
+	std::vector<u32> sorted( m_games.size() );
+	for( uint i=0; i<sorted.size(); ++i ) sorted[i] = i;
+
+	std::stable_sort( sorted.begin(), sorted.end(), GameDbCacheIndexSort( *this ) );
+
+	m_index.clear();
+	m_index.reserve( sorted.size() );
+
+	for( uint i=0; i<sorted.size(); ++i )
+	{
+		if( (i+1 < sorted.size()) && (CompareGames( sorted[i], sorted[i+1] ) == 0) ) continue;
+		m_index.push_back( sorted[i] );
+	}
+}
+
+bool GameDbCacheWriter::Write( const wxString& file, const wxString& header, u64 srcSize, s64 srcTime )
+{
+	GameDbCacheHeader hdr;
+	memset( &hdr, 0, sizeof(hdr) );
+
+	memcpy( hdr.Magic, GameDbCacheMagic, sizeof(GameDbCacheMagic) );
+	hdr.SourceSize		= srcSize;
+	hdr.SourceTime		= srcTime;
+	hdr.Version			= GameDbCacheVersion;
+
+	hdr.HeaderStr		= Intern( header );
+	hdr.StringCount		= m_strings.size();
+	hdr.GameCount		= m_games.size();
+	hdr.PairCount		= m_pairs.size();
+	hdr.IndexCount		= m_index.size();
+
+	hdr.StringTableOfs	= sizeof(hdr);
+	hdr.GameTableOfs	= hdr.StringTableOfs	+ hdr.StringCount	* sizeof(GameDbCacheString);
+	hdr.PairTableOfs	= hdr.GameTableOfs		+ hdr.GameCount		* sizeof(GameDbCacheGame);
+	hdr.IndexTableOfs	= hdr.PairTableOfs		+ hdr.PairCount		* sizeof(GameDbCachePair);
+	hdr.StringDataOfs	= hdr.IndexTableOfs		+ hdr.IndexCount	* sizeof(u32);
+	hdr.StringDataSize	= m_data.length();
+	hdr.FileSize		= hdr.StringDataOfs		+ hdr.StringDataSize;
+
+	// Write to a temporary and rename it into place, so that an interrupted write can never
+	// leave behind a cache that passes validation.
+	const wxString tmpfile( file + L".tmp" );
+	{
+		wxFFile fp( tmpfile, L"wb" );
+		if( !fp.IsOpened() ) return false;
+
+		bool ok = fp.Write( &hdr, sizeof(hdr) ) == sizeof(hdr);
+		if( ok && !m_strings.empty() )	ok = fp.Write( &m_strings[0],	m_strings.size()	* sizeof(GameDbCacheString) ) == m_strings.size()	* sizeof(GameDbCacheString);
+		if( ok && !m_games.empty() )	ok = fp.Write( &m_games[0],		m_games.size()		* sizeof(GameDbCacheGame) )	== m_games.size()	* sizeof(GameDbCacheGame);
+		if( ok && !m_pairs.empty() )	ok = fp.Write( &m_pairs[0],		m_pairs.size()		* sizeof(GameDbCachePair) )	== m_pairs.size()	* sizeof(GameDbCachePair);
+		if( ok && !m_index.empty() )	ok = fp.Write( &m_index[0],		m_index.size()		* sizeof(u32) )				== m_index.size()	* sizeof(u32);
+		if( ok && !m_data.empty() )		ok = fp.Write( m_data.data(),	m_data.length() )	== m_data.length();
+
+		if( !fp.Close() ) ok = false;
+		if( !ok )
+		{
+			wxRemoveFile( tmpfile );
+			return false;
+		}
+	}
+
+	return wxRenameFile( tmpfile, file, true );
+}
+
 // --------------------------------------------------------------------------------------
 //  AppGameDatabase  (implementations)
 // --------------------------------------------------------------------------------------
 
+AppGameDatabase::AppGameDatabase()
+{
+}
+
+AppGameDatabase::~AppGameDatabase() throw()
+{
+	Console.WriteLn( "(GameDB) Unloading..." );
+}
+
+bool AppGameDatabase::findGame(Game_Data& dest, const wxString& id)
+{
+	// Games added or edited at runtime override whatever the compiled database has.
+	if( _parent::findGame( dest, id ) ) return true;
+	return m_cache && m_cache->Find( dest, id );
+}
+
+bool AppGameDatabase::LoadFromCache( const wxString& cachefile, const wxFileName& source )
+{
+	ScopedPtr<GameDatabaseCache> cache( new GameDatabaseCache() );
+
+	if( !cache->Open( cachefile ) ) return false;
+	if( !cache->IsCurrent( source.GetSize().GetValue(), source.GetModificationTime().GetTicks() ) )
+	{
+		Console.WriteLn( "(GameDB) Compiled database is out of date; reloading from text." );
+		return false;
+	}
+
+	header = cache->GetHeader();
+	m_cache = cache.DetachPtr();
+	return true;
+}
+
+void AppGameDatabase::WriteCache( const wxString& cachefile, const wxFileName& source )
+{
+	GameDbCacheWriter writer;
+
+	for(uint blockidx=0; blockidx<=m_BlockTableWritePos; ++blockidx)
+	{
+		if( !m_BlockTable[blockidx] ) continue;
+
+		const uint endidx = (blockidx == m_BlockTableWritePos) ? m_CurBlockWritePos : m_GamesPerBlock;
+
+		for( uint gameidx=0; gameidx<endidx; ++gameidx )
+			writer.AddGame( m_BlockTable[blockidx][gameidx] );
+	}
+
+	writer.BuildIndex();
+
+	if( !writer.Write( cachefile, header, source.GetSize().GetValue(), source.GetModificationTime().GetTicks() ) )
+		Console.Warning( L"(GameDB) Could not write compiled database [%s]", cachefile.c_str() );
+}
+
+// Copies every game from the compiled database into the regular (editable) hash table and
+// drops the mapping.  Only needed when the whole database has to be walked, ie. for saving.
+void AppGameDatabase::UnpackCache()
+{
+	if( !m_cache ) return;
+
+	Game_Data game;
+	const uint count = m_cache->GetGameCount();
+	for( uint i=0; i<count; ++i )
+	{
+		m_cache->GetGame( game, i );
+		if( !game.IsOk() || (gHash.find( game.id ) != gHash.end()) ) continue;
+		*createNewGame( game.id ) = game;
+	}
+
+	m_cache = NULL;
+}
+
 AppGameDatabase& AppGameDatabase::LoadFromFile(const wxString& _file, const wxString& key )
 {
 	wxString file(_file);
@@ -176,9 +713,26 @@ AppGameDatabase& AppGameDatabase::LoadFromFile(const wxString& _file, const wxSt
 		return *this;
 	}
 
+	const wxFileName source( file );
+	const wxString cachefile( GetSettingsFolder().Combine( wxFileName(L"GameIndex.cache") ).GetFullPath() );
+
+	u64 qpc_Start = GetCPUTicks();
+
+	if( LoadFromCache( cachefile, source ) )
+	{
+		u64 qpc_end = GetCPUTicks();
+
+		Console.WriteLn( "(GameDB) %d games on record (mapped %uKB compiled database in %ums)",
+			m_cache->GetIndexCount(), (u32)(m_cache->GetSize() / 1024),
+			(u32)(((qpc_end-qpc_Start)*1000) / GetTickFrequency()) );
+
+		return *this;
+	}
+
 	wxFFileInputStream reader( file );
+	const bool readable = reader.IsOk();
 
-	if (!reader.IsOk())
+	if (!readable)
 	{
 		//throw Exception::FileNotFound( file );
 		Console.Error(L"(GameDB) Could not access file (permission denied?) [%s]", file.c_str());
@@ -186,7 +740,6 @@ AppGameDatabase& AppGameDatabase::LoadFromFile(const wxString& _file, const wxSt
 
 	DBLoaderHelper loader( reader, *this );
 
-	u64 qpc_Start = GetCPUTicks();
 	header = loader.ReadHeader();
 	loader.ReadGames();
 	u64 qpc_end = GetCPUTicks();
@@ -194,12 +747,16 @@ AppGameDatabase& AppGameDatabase::LoadFromFile(const wxString& _file, const wxSt
 	Console.WriteLn( "(GameDB) %d games on record (loaded in %ums)",
 		gHash.size(), (u32)(((qpc_end-qpc_Start)*1000) / GetTickFrequency()) );
 
+	if( readable && !gHash.empty() ) WriteCache( cachefile, source );
+
 	return *this;
 }
 
 // Saves changes to the database
 
 void AppGameDatabase::SaveToFile(const wxString& file) {
+	UnpackCache();
+
 	wxFFileOutputStream writer( file );
 	pxWriteMultiline(writer, header);
 
@@ -209,7 +766,7 @@ void AppGameDatabase::SaveToFile(const wxString& file) {
 
 		const uint endidx = (blockidx == m_BlockTableWritePos) ? m_CurBlockWritePos : m_GamesPerBlock;
 
-		for( uint gameidx=0; gameidx<=endidx; ++gameidx )
+		for( uint gameidx=0; gameidx<endidx; ++gameidx )
 		{
 			const Game_Data& game( m_BlockTable[blockidx][gameidx] );
 			KeyPairArray::const_iterator i(game.kList.begin());
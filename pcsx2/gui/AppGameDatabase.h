@@ -17,6 +17,8 @@
 
 #include "GameDatabase.h"
 
+class GameDatabaseCache;
+
 // --------------------------------------------------------------------------------------
 //  AppGameDatabase
 // --------------------------------------------------------------------------------------
@@ -38,18 +40,29 @@
 // After the constructor loads the game data, you can use the
 // GameDatabase class's methods to get the other key's values.
 // Such as dbLoader.getString("Region") returns "NTSC-U"
+//
+// Parsing the text database is slow enough to be noticeable at startup, so the first load
+// also compiles it into GameIndex.cache (in the settings folder).  Subsequent loads map the
+// compiled form directly and look games up through its sorted serial index; the text file
+// is only parsed again when its size or timestamp no longer match the cache.  Games that are
+// created or edited at runtime live in the regular hash table and take precedence over the
+// cached entries.
 
 class AppGameDatabase : public BaseGameDatabaseImpl
 {
+	typedef BaseGameDatabaseImpl _parent;
+
 protected:
 	wxString		header;			// Header of the database
 	wxString		baseKey;		// Key to separate games by ("Serial")
 
+	ScopedPtr<GameDatabaseCache>	m_cache;	// compiled database, if one was loaded
+
 public:
-	AppGameDatabase() {}
-	virtual ~AppGameDatabase() throw() {
-		Console.WriteLn( "(GameDB) Unloading..." );
-	}
+	AppGameDatabase();
+	virtual ~AppGameDatabase() throw();
+
+	bool findGame(Game_Data& dest, const wxString& id);
 
 	// Each linux distributions have his rules for path so we give them the possibility to
 	// change it with compilation flags. -- Gregory
@@ -62,6 +75,11 @@ public:
 	AppGameDatabase& LoadFromFile(const wxString& file = Path::Combine( wxString(xGAMEINDEX_str(GAMEINDEX_DIR_COMPILATION), wxConvUTF8) , L"GameIndex.dbf" ), const wxString& key = L"Serial" );
 	void SaveToFile(const wxString& file = Path::Combine( wxString(xGAMEINDEX_str(GAMEINDEX_DIR_COMPILATION), wxConvUTF8) , L"GameIndex.dbf") );
 #endif
+
+protected:
+	bool LoadFromCache( const wxString& cachefile, const wxFileName& source );
+	void WriteCache( const wxString& cachefile, const wxFileName& source );
+	void UnpackCache();
 };
 
 static wxString compatToStringWX(int compat) {
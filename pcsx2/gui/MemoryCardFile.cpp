@@ -35,22 +35,110 @@ struct Component_FileMcd;
 
 #include <wx/ffile.h>
 
+#include "Utilities/PersistentThread.h"
+
+#ifdef __WXMSW__
+#	include <io.h>
+#else
+#	include <unistd.h>
+#endif
+
 static const int MCD_SIZE	= 1024 *  8  * 16;		// Legacy PSX card default size
 
 static const int MC2_MBSIZE	= 1024 * 528 * 2;		// Size of a single megabyte of card data
 static const int MC2_SIZE	= MC2_MBSIZE * 8;		// PS2 card default size (8MB)
 
+static const int MCD_ERASEBLOCK_SIZE = 528 * 16;	// 16 sectors with ECC; the write-back granularity
+
+// Dirty blocks are written back this long after the first write that dirtied them, so
+// that the bursts of small sector writes games do on save are coalesced into one write.
+static const int MCD_FLUSH_DELAY_MS = 500;
+
+class FileMemoryCard;
+
+// --------------------------------------------------------------------------------------
+//  FileMcdFlushThread
+// --------------------------------------------------------------------------------------
+// Writes dirty erase blocks of the cached card images back to disk, off the EE thread.
+//
+class FileMcdFlushThread : public pxThread
+{
+	typedef pxThread _parent;
+
+protected:
+	FileMemoryCard&		m_card;
+	volatile bool		m_quit;
+
+public:
+	FileMcdFlushThread( FileMemoryCard& card )
+		: pxThread( L"FileMcdFlush" )
+		, m_card( card )
+	{
+		m_quit = false;
+	}
+
+	virtual ~FileMcdFlushThread() throw()
+	{
+		_parent::Cancel();
+	}
+
+	// Wakes the thread to flush after the coalescing delay.
+	void Kick()
+	{
+		m_sem_event.Post();
+	}
+
+	// Stops the thread without cancelling it mid-write; any pending flush completes first.
+	void Shutdown()
+	{
+		m_quit = true;
+		m_sem_event.Post();
+		Block();
+	}
+
+protected:
+	void ExecuteTaskInThread();
+};
+
 // --------------------------------------------------------------------------------------
 //  FileMemoryCard
 // --------------------------------------------------------------------------------------
-// Provides thread-safe direct file IO mapping.
+// Provides thread-safe cached file IO mapping.
+//
+// Each card file is loaded into memory in its entirety when opened.  Reads are served
+// from the cached image, and writes/erases only modify the image and mark the affected
+// erase blocks dirty.  FileMcdFlushThread writes dirty blocks back in coalesced runs,
+// and everything is flushed and synced to disk when the card is closed (which happens
+// whenever emulation is suspended or shut down).
 //
 class FileMemoryCard
 {
+	friend class FileMcdFlushThread;
+
 protected:
+	struct IoStats
+	{
+		u32		Reads;
+		u32		Saves;
+		u32		Erases;
+		u32		DiskWrites;		// Seek+Write calls issued by the write-back
+		u64		BytesWritten;
+		u64		TicksTotal;		// time spent in Read/Save/EraseBlock, in GetCPUTicks units
+		u64		TicksMax;
+	};
+
 	wxFFile			m_file[8];
 	u8				m_effeffs[528*16];
-	SafeArray<u8>	m_currentdata;
+
+	SafeArray<u8>	m_image[8];			// complete card file contents (header included)
+	u32				m_offset[8];		// legacy PSX card header size (see GetCardOffset)
+	SafeArray<u8>	m_dirty[8];			// one flag per erase block of m_image
+	bool			m_anydirty[8];
+	IoStats			m_stats[8];
+
+	Mutex			m_mtx_image;
+
+	ScopedPtr<FileMcdFlushThread>	m_flusher;
 
 public:
 	FileMemoryCard();
@@ -70,7 +158,15 @@ public:
 	u64  GetCRC		( uint slot );
 
 protected:
-	bool Seek( wxFFile& f, u32 adr );
+	bool Load( uint slot );
+	u8*  GetPtr( uint slot, u32 adr, int size );
+	void MarkDirty( uint slot, u32 adr, int size );
+	void Flush( uint slot );
+	void FlushAll();
+	void SyncToDisk( uint slot );
+	void LogStats( uint slot ) const;
+	void AddLatency( uint slot, u64 startTicks );
+
 	bool Create( const wxString& mcdFile, uint sizeInMB );
 
 	wxString GetDisabledMessage( uint slot ) const
@@ -83,6 +179,21 @@ protected:
 	}
 };
 
+void FileMcdFlushThread::ExecuteTaskInThread()
+{
+	while( !m_quit )
+	{
+		m_sem_event.WaitWithoutYield();
+		if( m_quit ) break;
+
+		// Give the game a moment to finish its burst of writes before writing back.
+		Threading::Sleep( MCD_FLUSH_DELAY_MS );
+		m_sem_event.Reset();
+
+		m_card.FlushAll();
+	}
+}
+
 uint FileMcd_GetMtapPort(uint slot)
 {
 	switch( slot )
@@ -139,6 +250,9 @@ wxString FileMcd_GetDefaultName(uint slot)
 FileMemoryCard::FileMemoryCard()
 {
 	memset8<0xff>( m_effeffs );
+	memzero( m_offset );
+	memzero( m_anydirty );
+	memzero( m_stats );
 }
 
 void FileMemoryCard::Open()
@@ -202,36 +316,237 @@ void FileMemoryCard::Open()
 				GetDisabledMessage( slot )
 			);
 		}
+		else if( !Load( slot ) )
+		{
+			m_file[slot].Close();
+			Msgbox::Alert(
+				wxsFormat(_( "Could not read memory card: \n\n%s\n\n" ), str.c_str()) +
+				GetDisabledMessage( slot )
+			);
+		}
 	}
+
+	m_flusher = new FileMcdFlushThread( *this );
+	m_flusher->Start();
 }
 
 void FileMemoryCard::Close()
 {
+	if( m_flusher ) m_flusher->Shutdown();
+	m_flusher = NULL;
+
 	for( int slot=0; slot<8; ++slot )
+	{
+		if( m_file[slot].IsOpened() )
+		{
+			Flush( slot );
+			SyncToDisk( slot );
+			LogStats( slot );
+		}
+
 		m_file[slot].Close();
+		m_image[slot].Dispose();
+		m_dirty[slot].Dispose();
+	}
 }
 
-// Returns FALSE if the seek failed (is outside the bounds of the file).
-bool FileMemoryCard::Seek( wxFFile& f, u32 adr )
+// Reads the whole card file into the slot's image.  Returns FALSE on read error.
+bool FileMemoryCard::Load( uint slot )
 {
-	const u32 size = f.Length();
+	wxFFile& mcfp( m_file[slot] );
+	const u32 size = mcfp.Length();
 
 	// If anyone knows why this filesize logic is here (it appears to be related to legacy PSX
 	// cards, perhaps hacked support for some special emulator-specific memcard formats that
 	// had header info?), then please replace this comment with something useful.  Thanks!  -- air
 
-	u32 offset = 0;
-
 	if( size == MCD_SIZE + 64 )
-		offset = 64;
+		m_offset[slot] = 64;
 	else if( size == MCD_SIZE + 3904 )
-		offset = 3904;
+		m_offset[slot] = 3904;
 	else
 	{
 		// perform sanity checks here?
+		m_offset[slot] = 0;
+	}
+
+	const uint blocks = (size + MCD_ERASEBLOCK_SIZE - 1) / MCD_ERASEBLOCK_SIZE;
+
+	m_image[slot].ExactAlloc( size );
+	m_dirty[slot].ExactAlloc( blocks );
+	memset( m_dirty[slot].GetPtr(), 0, blocks );
+	m_anydirty[slot] = false;
+	memzero( m_stats[slot] );
+
+	if( !mcfp.Seek( 0 ) ) return false;
+	return mcfp.Read( m_image[slot].GetPtr(), size ) == size;
+}
+
+// Returns a pointer into the cached image for the given card address, or NULL if the
+// access falls outside of the card file.
+u8* FileMemoryCard::GetPtr( uint slot, u32 adr, int size )
+{
+	const u32 pos = adr + m_offset[slot];
+
+	if( (size < 0) || (pos < adr) || ((u64)pos + size > (u64)m_image[slot].GetSizeInBytes()) )
+		return NULL;
+
+	return m_image[slot].GetPtr( pos );
+}
+
+void FileMemoryCard::MarkDirty( uint slot, u32 adr, int size )
+{
+	if( size <= 0 ) return;
+
+	const u32 pos = adr + m_offset[slot];
+	const uint first = pos / MCD_ERASEBLOCK_SIZE;
+	const uint last  = (pos + size - 1) / MCD_ERASEBLOCK_SIZE;
+
+	for( uint i=first; i<=last; ++i )
+		m_dirty[slot][i] = 1;
+
+	if( !m_anydirty[slot] )
+	{
+		m_anydirty[slot] = true;
+		if( m_flusher ) m_flusher->Kick();
+	}
+}
+
+// Writes dirty blocks of the slot's image back to the card file, merging runs of
+// adjacent dirty blocks into single writes.  The runs are copied out while the image is
+// locked and written after releasing it, so Read/Save/EraseBlock never wait for the disk.
+// Blocks whose write fails are marked dirty again, to be retried by the next flush.
+// Only one thread writes to the file at a time: the flusher, or Close after stopping it.
+void FileMemoryCard::Flush( uint slot )
+{
+	struct DirtyRun
+	{
+		u32 pos;
+		u32 len;
+		bool failed;
+	};
+
+	std::vector<DirtyRun> runs;
+	std::vector<u8> data;
+
+	{
+		ScopedLock lock( m_mtx_image );
+
+		if( !m_anydirty[slot] ) return;
+
+		const uint blocks = m_dirty[slot].GetLength();
+		const u32 imagesize = m_image[slot].GetSizeInBytes();
+
+		for( uint i=0; i<blocks; )
+		{
+			if( !m_dirty[slot][i] ) { ++i; continue; }
+
+			uint end = i;
+			while( (end < blocks) && m_dirty[slot][end] )
+				m_dirty[slot][end++] = 0;
+
+			DirtyRun run;
+			run.pos = i * MCD_ERASEBLOCK_SIZE;
+			run.len = std::min( end * MCD_ERASEBLOCK_SIZE, imagesize ) - run.pos;
+			run.failed = false;
+			runs.push_back( run );
+
+			const u8* src = m_image[slot].GetPtr( run.pos );
+			data.insert( data.end(), src, src + run.len );
+
+			i = end;
+		}
+
+		m_anydirty[slot] = false;
 	}
 
-	return f.Seek( adr + offset );
+	if( runs.empty() ) return;
+
+	wxFFile& mcfp( m_file[slot] );
+	const u8* src = &data[0];
+	u64 written = 0;
+	bool failed = false;
+
+	for( uint r=0; r<runs.size(); ++r )
+	{
+		DirtyRun& run( runs[r] );
+
+		if( mcfp.Seek( run.pos ) && (mcfp.Write( src, run.len ) == run.len) )
+			written += run.len;
+		else
+		{
+			Console.Error( "(FileMcd) Write-back to slot %u failed at offset 0x%x (%u bytes), will retry.", slot, run.pos, run.len );
+			run.failed = failed = true;
+		}
+
+		src += run.len;
+	}
+
+	mcfp.Flush();
+
+	ScopedLock lock( m_mtx_image );
+
+	m_stats[slot].DiskWrites += runs.size();
+	m_stats[slot].BytesWritten += written;
+
+	if( !failed ) return;
+
+	// The image may have changed meanwhile, the next flush writes its current contents.
+	for( uint r=0; r<runs.size(); ++r )
+	{
+		if( !runs[r].failed ) continue;
+
+		const uint first = runs[r].pos / MCD_ERASEBLOCK_SIZE;
+		const uint last  = (runs[r].pos + runs[r].len - 1) / MCD_ERASEBLOCK_SIZE;
+
+		for( uint i=first; i<=last; ++i )
+			m_dirty[slot][i] = 1;
+	}
+
+	if( !m_anydirty[slot] )
+	{
+		m_anydirty[slot] = true;
+		if( m_flusher ) m_flusher->Kick();
+	}
+}
+
+void FileMemoryCard::FlushAll()
+{
+	for( int slot=0; slot<8; ++slot )
+		if( m_file[slot].IsOpened() ) Flush( slot );
+}
+
+// Makes sure the OS has committed the card file to storage, not just to its cache.
+void FileMemoryCard::SyncToDisk( uint slot )
+{
+	wxFFile& mcfp( m_file[slot] );
+	mcfp.Flush();
+
+#ifdef __WXMSW__
+	_commit( _fileno( mcfp.fp() ) );
+#else
+	fsync( fileno( mcfp.fp() ) );
+#endif
+}
+
+void FileMemoryCard::AddLatency( uint slot, u64 startTicks )
+{
+	const u64 ticks = GetCPUTicks() - startTicks;
+	m_stats[slot].TicksTotal += ticks;
+	if( ticks > m_stats[slot].TicksMax ) m_stats[slot].TicksMax = ticks;
+}
+
+void FileMemoryCard::LogStats( uint slot ) const
+{
+	const IoStats& st( m_stats[slot] );
+	const u32 calls = st.Reads + st.Saves + st.Erases;
+	if( calls == 0 ) return;
+
+	const double usPerTick = 1000000.0 / GetTickFrequency();
+
+	Console.WriteLn( Color_Gray, "(FileMcd) Slot %u: %u reads, %u saves, %u erases -> %u disk writes (%u KB); avg %.1f us, max %.1f us per call",
+		slot, st.Reads, st.Saves, st.Erases, st.DiskWrites, (u32)(st.BytesWritten / 1024),
+		st.TicksTotal * usPerTick / calls, st.TicksMax * usPerTick );
 }
 
 // returns FALSE if an error occurred (either permission denied or disk full)
@@ -263,79 +578,107 @@ void FileMemoryCard::GetSizeInfo( uint slot, PS2E_McdSizeInfo& outways )
 	outways.EraseBlockSizeInSectors			= 16;
 
 	if( pxAssert( m_file[slot].IsOpened() ) )
-		outways.McdSizeInSectors	= m_file[slot].Length() / (outways.SectorSize + outways.EraseBlockSizeInSectors);
+		outways.McdSizeInSectors	= m_image[slot].GetSizeInBytes() / (outways.SectorSize + outways.EraseBlockSizeInSectors);
 	else
 		outways.McdSizeInSectors	= 0x4000;
 }
 
 s32 FileMemoryCard::Read( uint slot, u8 *dest, u32 adr, int size )
 {
-	wxFFile& mcfp( m_file[slot] );
-	if( !mcfp.IsOpened() )
+	if( !m_file[slot].IsOpened() )
 	{
 		DevCon.Error( "(FileMcd) Ignoring attempted read from disabled slot." );
 		memset(dest, 0, size);
 		return 1;
 	}
-	if( !Seek(mcfp, adr) ) return 0;
-	return mcfp.Read( dest, size ) != 0;
+
+	const u64 startTicks = GetCPUTicks();
+	ScopedLock lock( m_mtx_image );
+
+	const u8* src = GetPtr( slot, adr, size );
+	if( src == NULL ) return 0;
+
+	memcpy_fast( dest, src, size );
+
+	++m_stats[slot].Reads;
+	AddLatency( slot, startTicks );
+	return 1;
 }
 
 s32 FileMemoryCard::Save( uint slot, const u8 *src, u32 adr, int size )
 {
-	wxFFile& mcfp( m_file[slot] );
-
-	if( !mcfp.IsOpened() )
+	if( !m_file[slot].IsOpened() )
 	{
 		DevCon.Error( "(FileMcd) Ignoring attempted save/write to disabled slot." );
 		return 1;
 	}
 
-	if( !Seek(mcfp, adr) ) return 0;
-	m_currentdata.MakeRoomFor( size );
-	mcfp.Read( m_currentdata.GetPtr(), size);
+	const u64 startTicks = GetCPUTicks();
+	ScopedLock lock( m_mtx_image );
+
+	u8* dest = GetPtr( slot, adr, size );
+	if( dest == NULL ) return 0;
 
+	bool uncleared = false;
 	for (int i=0; i<size; i++)
 	{
-		if ((m_currentdata[i] & src[i]) != src[i])
-			Console.Warning("(FileMcd) Warning: writing to uncleared data.");
-		m_currentdata[i] &= src[i];
+		if ((dest[i] & src[i]) != src[i])
+			uncleared = true;
+		dest[i] &= src[i];
 	}
 
-	if( !Seek(mcfp, adr) ) return 0;
-	return mcfp.Write( m_currentdata.GetPtr(), size ) != 0;
+	if( uncleared )
+		Console.Warning("(FileMcd) Warning: writing to uncleared data.");
+
+	MarkDirty( slot, adr, size );
+
+	++m_stats[slot].Saves;
+	AddLatency( slot, startTicks );
+	return 1;
 }
 
 s32 FileMemoryCard::EraseBlock( uint slot, u32 adr )
 {
-	wxFFile& mcfp( m_file[slot] );
-
-	if( !mcfp.IsOpened() )
+	if( !m_file[slot].IsOpened() )
 	{
 		DevCon.Error( "MemoryCard: Ignoring erase for disabled slot." );
 		return 1;
 	}
 
-	if( !Seek(mcfp, adr) ) return 0;
-	return mcfp.Write( m_effeffs, sizeof(m_effeffs) ) != 0;
+	const u64 startTicks = GetCPUTicks();
+	ScopedLock lock( m_mtx_image );
+
+	u8* dest = GetPtr( slot, adr, sizeof(m_effeffs) );
+	if( dest == NULL ) return 0;
+
+	memcpy_fast( dest, m_effeffs, sizeof(m_effeffs) );
+	MarkDirty( slot, adr, sizeof(m_effeffs) );
+
+	++m_stats[slot].Erases;
+	AddLatency( slot, startTicks );
+	return 1;
 }
 
 u64 FileMemoryCard::GetCRC( uint slot )
 {
-	wxFFile& mcfp( m_file[slot] );
-	if( !mcfp.IsOpened() ) return 0;
+	if( !m_file[slot].IsOpened() ) return 0;
 
-	if( !Seek( mcfp, 0 ) ) return 0;
+	ScopedLock lock( m_mtx_image );
 
-	// Process the file in 4k chunks.  Speeds things up significantly.
+	// Same result as the old file-based version: XOR of all whole 33792 byte chunks
+	// (sector size * 64) of the file, starting at the card data offset.
 	u64 retval = 0;
-	u64 buffer[528*8];		// use 528 (sector size), ensures even divisibility
-	
-	const uint filesize = mcfp.Length() / sizeof(buffer);
-	for( uint i=filesize; i; --i )
+	const uint chunksize = 528*8*sizeof(u64);
+	const uint imagesize = m_image[slot].GetSizeInBytes();
+
+	const uint chunks = imagesize / chunksize;
+	for( uint i=0; i<chunks; ++i )
 	{
-		mcfp.Read( &buffer, sizeof(buffer) );
-		for( uint t=0; t<ArraySize(buffer); ++t )
+		const uint pos = m_offset[slot] + i * chunksize;
+		if( pos + chunksize > imagesize ) break;
+
+		const u64* buffer = (const u64*)m_image[slot].GetPtr( pos );
+		for( uint t=0; t<chunksize/sizeof(u64); ++t )
 			retval ^= buffer[t];
 	}
 
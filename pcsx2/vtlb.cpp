@@ -56,37 +56,18 @@ static vtlbHandler UnmappedVirtHandler1;
 static vtlbHandler UnmappedPhyHandler0;
 static vtlbHandler UnmappedPhyHandler1;
 
-__inline int CheckCache(u32 addr)
+// Cached pages are tracked per 4k page by the TLB code (see cacheUpdatePages).
+__fi int CheckCache(u32 addr)
 {
-	u32 mask;
-
 	if(((cpuRegs.CP0.n.Config >> 16) & 0x1) == 0) 
 	{
 		//DevCon.Warning("Data Cache Disabled! %x", cpuRegs.CP0.n.Config);
 		return false;//
 	}
 
-	for(int i = 1; i < 48; i++)
-	{
-		if (((tlb[i].EntryLo1 & 0x38) >> 3) == 0x3) {
-			mask  = tlb[i].PageMask;
-			
-			if ((addr >= tlb[i].PFN1) && (addr <= tlb[i].PFN1 + mask)) {
-				//DevCon.Warning("Yay! Cache check cache addr=%x, mask=%x, addr+mask=%x, VPN2=%x PFN0=%x", addr, mask, (addr & mask), tlb[i].VPN2, tlb[i].PFN0); 
-				return true;
-			}
-		}
-		if (((tlb[i].EntryLo0 & 0x38) >> 3) == 0x3) {
-			mask  = tlb[i].PageMask;
-			
-			if ((addr >= tlb[i].PFN0) && (addr <= tlb[i].PFN0 + mask)) {
-				//DevCon.Warning("Yay! Cache check cache addr=%x, mask=%x, addr+mask=%x, VPN2=%x PFN0=%x", addr, mask, (addr & mask), tlb[i].VPN2, tlb[i].PFN0); 
-				return true;
-			}
-		}
-	}
-	return false;
+	return pCachePages[addr >> VTLB_PAGE_BITS];
 }
+
 // --------------------------------------------------------------------------------------
 // Interpreter Implementations of VTLB Memory Operations.
 // --------------------------------------------------------------------------------------
@@ -101,24 +82,21 @@ DataType __fastcall vtlb_memRead(u32 addr)
 
 	if (!(ppf<0))
 	{
-		if (!CHECK_EEREC) 
+		if(CHECK_CACHE && CheckCache(addr)) 
 		{
-			if(CHECK_CACHE && CheckCache(addr)) 
+			switch( DataSize )
 			{
-				switch( DataSize )
-				{
-					case 8: 
-						return readCache8(addr);
-						break;
-					case 16: 
-						return readCache16(addr);
-						break;
-					case 32: 
-						return readCache32(addr);
-						break;
-
-					jNO_DEFAULT;
-				}
+				case 8: 
+					return readCache8(addr);
+					break;
+				case 16: 
+					return readCache16(addr);
+					break;
+				case 32: 
+					return readCache32(addr);
+					break;
+
+				jNO_DEFAULT;
 			}
 		}
 
@@ -156,12 +134,10 @@ void __fastcall vtlb_memRead64(u32 mem, mem64_t *out)
 
 	if (!(ppf<0))
 	{
-		if (!CHECK_EEREC) {
-			if(CHECK_CACHE && CheckCache(mem)) 
-			{
-				*out = readCache64(mem);
-				return;
-			}
+		if(CHECK_CACHE && CheckCache(mem)) 
+		{
+			*out = readCache64(mem);
+			return;
 		}
 
 		*out = *(mem64_t*)ppf;
@@ -183,14 +159,11 @@ void __fastcall vtlb_memRead128(u32 mem, mem128_t *out)
 
 	if (!(ppf<0))
 	{
-		if (!CHECK_EEREC) 
+		if(CHECK_CACHE && CheckCache(mem)) 
 		{
-			if(CHECK_CACHE && CheckCache(mem)) 
-			{
-				out->lo = readCache64(mem);
-				out->hi = readCache64(mem+8);
-				return;
-			}
+			out->lo = readCache64(mem);
+			out->hi = readCache64(mem+8);
+			return;
 		}
 
 		CopyQWC(out,(void*)ppf);
@@ -215,22 +188,19 @@ void __fastcall vtlb_memWrite(u32 addr, DataType data)
 	s32 ppf=addr+vmv;
 	if (!(ppf<0))
 	{		
-		if (!CHECK_EEREC) 
+		if(CHECK_CACHE && CheckCache(addr)) 
 		{
-			if(CHECK_CACHE && CheckCache(addr)) 
+			switch( DataSize )
 			{
-				switch( DataSize )
-				{
-				case 8: 
-					writeCache8(addr, data);
-					return;
-				case 16:
-					writeCache16(addr, data);
-					return;
-				case 32:
-					writeCache32(addr, data);
-					return;
-				}
+			case 8: 
+				writeCache8(addr, data);
+				return;
+			case 16:
+				writeCache16(addr, data);
+				return;
+			case 32:
+				writeCache32(addr, data);
+				return;
 			}
 		}
 
@@ -263,13 +233,10 @@ void __fastcall vtlb_memWrite64(u32 mem, const mem64_t* value)
 	s32 ppf=mem+vmv;
 	if (!(ppf<0))
 	{		
-		if (!CHECK_EEREC) 
+		if(CHECK_CACHE && CheckCache(mem)) 
 		{
-			if(CHECK_CACHE && CheckCache(mem)) 
-			{
-				writeCache64(mem, *value);
-				return;
-			}
+			writeCache64(mem, *value);
+			return;
 		}
 
 		*(mem64_t*)ppf = *value;
@@ -291,13 +258,10 @@ void __fastcall vtlb_memWrite128(u32 mem, const mem128_t *value)
 	s32 ppf=mem+vmv;
 	if (!(ppf<0))
 	{
-		if (!CHECK_EEREC) 
+		if(CHECK_CACHE && CheckCache(mem)) 
 		{
-			if(CHECK_CACHE && CheckCache(mem)) 
-			{
-				writeCache128(mem, value);
-				return;
-			}
+			writeCache128(mem, value);
+			return;
 		}
 
 		CopyQWC((void*)ppf, value);
@@ -87,6 +87,21 @@ extern void vtlb_DynGenWrite_Const( u32 bits, u32 addr_const );
 extern void vtlb_DynGenRead64_Const( u32 bits, u32 addr_const );
 extern void vtlb_DynGenRead32_Const( u32 bits, bool sign, u32 addr_const );
 
+extern void vtlb_DynGenWrite_Spec( u32 bits, u32 addr_guess );
+extern void vtlb_DynGenRead64_Spec( u32 bits, u32 addr_guess );
+extern void vtlb_DynGenRead32_Spec( u32 bits, bool sign, u32 addr_guess );
+
+// Speculative direct accesses (see vtlb_DynGenRead32_Spec).  Hits are only counted
+// in devel builds, since the counter update would sit on every guarded access.
+struct vtlb_SpecStats
+{
+	u32 sites;		// guarded accesses generated
+	u32 hits;		// runtime accesses that passed the guard
+	u32 misses;		// runtime accesses that took the full lookup
+};
+
+extern vtlb_SpecStats vtlb_specStats;
+
 // --------------------------------------------------------------------------------------
 //  VtlbMemoryReserve
 // --------------------------------------------------------------------------------------
@@ -72,9 +72,21 @@ void BaseBlocks::Link(u32 pc, s32* jumpptr)
 {
 	BASEBLOCKEX *targetblock = Get(pc);
 	if (targetblock && targetblock->startpc == pc)
-		*jumpptr = (s32)(targetblock->fnptr - (sptr)(jumpptr + 1));
+		*jumpptr = (s32)(targetblock->GetEntry() - (sptr)(jumpptr + 1));
 	else
 		*jumpptr = (s32)(recompiler - (sptr)(jumpptr + 1));
 	links.insert(std::pair<u32, uptr>(pc, (uptr)jumpptr));
 }
 
+// Points the jumps linked to the block to its checking entry, or back to its code.
+void BaseBlocks::SetChecking(int idx, bool checking)
+{
+	BASEBLOCKEX& block = blocks[idx];
+
+	pxAssert(block.checkfn);
+	block.checking = checking;
+
+	std::pair<linkiter_t, linkiter_t> range = links.equal_range(block.startpc);
+	for (linkiter_t i = range.first; i != range.second; ++i)
+		*(u32*)i->second = block.GetEntry() - (i->second + 4);
+}
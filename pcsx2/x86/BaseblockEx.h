@@ -35,6 +35,10 @@ struct BASEBLOCKEX
 	uptr fnptr;
 	u16 size;	// size in dwords
 	u16 x86size;
+	uptr checkfn;	// entry that verifies the code before jumping to fnptr, 0 if none
+	bool checking;	// jumps to the block go to checkfn (its page is not write protected)
+
+	__fi uptr GetEntry() const { return checking ? checkfn : fnptr; }
 
 #ifdef PCSX2_DEVBUILD
 	u32 visited; // number of times called
@@ -243,6 +247,7 @@ public:
 	}
 
 	void Link(u32 pc, s32* jumpptr);
+	void SetChecking(int idx, bool checking);
 
 	__fi void Reset()
 	{
@@ -27,6 +27,7 @@ __tls_emit u32 *j32Ptr[32];
 
 u16 g_x86AllocCounter = 0;
 u16 g_xmmAllocCounter = 0;
+RecRegStats g_recRegStats;
 
 EEINST* g_pCurInstInfo = NULL;
 
@@ -101,17 +102,25 @@ int  _getFreeXMMreg()
 		}
 	}
 
-	// check for future xmm usage
+	// check for future xmm usage, spilling the gpr that is read again
+	// furthest away (see recompileNextInstruction)
+	tempi = -1;
 	for (i=0; i<iREGCNT_XMM; i++) {
 		if (xmmregs[i].needed) continue;
 		if (xmmregs[i].type == XMMTYPE_GPRREG ) {
-			if( !(g_pCurInstInfo->regs[xmmregs[i].reg] & EEINST_XMM) ) {
-				_freeXMMreg(i);
-				return i;
+			if( !(g_pCurInstInfo->regs[xmmregs[i].reg] & EEINST_XMM) && xmmregs[i].counter < bestcount ) {
+				tempi = i;
+				bestcount = xmmregs[i].counter;
 			}
 		}
 	}
 
+	if( tempi != -1 ) {
+		g_recRegStats.spills++;
+		_freeXMMreg(tempi);
+		return tempi;
+	}
+
 	tempi = -1;
 	bestcount = 0xffff;
 	for (i=0; i<iREGCNT_XMM; i++) {
@@ -130,6 +139,7 @@ int  _getFreeXMMreg()
 	}
 
 	if( tempi != -1 ) {
+		g_recRegStats.spills++;
 		_freeXMMreg(tempi);
 		return tempi;
 	}
@@ -1066,6 +1076,25 @@ u32 _recIsRegUsed(EEINST* pinst, int size, u8 xmmtype, u8 reg)
 	return 0;
 }
 
+u32 _recIsRegRead(EEINST* pinst, int size, u8 xmmtype, u8 reg)
+{
+	u32 i, inst = 1;
+	while(size-- > 0) {
+		for(i = 0; i < ArraySize(pinst->readType); ++i) {
+			if( pinst->readType[i] == xmmtype && pinst->readReg[i] == reg )
+				return inst;
+		}
+		for(i = 0; i < ArraySize(pinst->writeType); ++i) {
+			if( pinst->writeType[i] == xmmtype && pinst->writeReg[i] == reg )
+				return 0;
+		}
+		++inst;
+		pinst++;
+	}
+
+	return 0;
+}
+
 void _recFillRegister(EEINST& pinst, int type, int reg, int write)
 {
 	u32 i = 0;
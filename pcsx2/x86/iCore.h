@@ -231,6 +231,8 @@ extern void _recClearInst(EEINST* pinst);
 extern u32 _recIsRegWritten(EEINST* pinst, int size, u8 xmmtype, u8 reg);
 // returns the number of insts + 1 until used (0 if not used)
 extern u32 _recIsRegUsed(EEINST* pinst, int size, u8 xmmtype, u8 reg);
+// returns the number of insts + 1 until read (0 if overwritten first or not read)
+extern u32 _recIsRegRead(EEINST* pinst, int size, u8 xmmtype, u8 reg);
 extern void _recFillRegister(EEINST& pinst, int type, int reg, int write);
 
 static __fi bool EEINST_ISLIVE64(u32 reg)	{ return !!(g_pCurInstInfo->regs[reg] & (EEINST_LIVE0)); }
@@ -250,6 +252,16 @@ extern __tls_emit u32 *j32Ptr[32];		// depreciated item.  use local u32* vars in
 extern u16 g_x86AllocCounter;
 extern u16 g_xmmAllocCounter;
 
+// Cached registers written back because the allocator ran out of registers
+// (spills) or because a call site flushed them (flushes).
+struct RecRegStats
+{
+	u32 spills;
+	u32 flushes;
+};
+
+extern RecRegStats g_recRegStats;
+
 // allocates only if later insts use XMM, otherwise checks
 int _allocCheckGPRtoXMM(EEINST* pinst, int gprreg, int mode);
 int _allocCheckFPUtoXMM(EEINST* pinst, int fpureg, int mode);
@@ -30,6 +30,22 @@ extern u32 pc;			         // recompiler pc (also used by the SuperVU! .. why? (a
 extern int branch;		         // set for branch (also used by the SuperVU! .. why? (air))
 extern u32 target;		         // branch target
 extern u32 s_nBlockCycles;		// cycles of current block recompiling
+extern u32 s_nEndBlock;			// what pc the current block ends
+extern bool g_recompilingDelaySlot;
+
+// VU0 state kept cached across consecutive COP2 macro ops: register write-backs
+// (flushes) and MAC flag updates that were not emitted.
+struct RecCop2Stats
+{
+	u32 flushes;
+	u32 macFlags;
+};
+
+extern RecCop2Stats g_recCop2Stats;
+
+extern bool recBlockCodeFull();		// the block's x86 code has reached the size where it is cut
+extern bool mVUmacroCached();		// the last macro op left the VU0 regs cached for the next one
+extern void mVUmacroReset();
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //
@@ -70,7 +86,9 @@ void SaveBranchState();
 void LoadBranchState();
 
 void recompileNextInstruction(int delayslot);
+void rpropBSC(EEINST* pinst);
 void SetBranchReg( u32 reg );
+void SetBranchReturn( u32 retpc );
 void SetBranchImm( u32 imm );
 
 void iFlushCall(int flushtype);
@@ -104,6 +122,7 @@ extern u32 g_cpuHasConstReg, g_cpuFlushedConstReg;
 
 // gets a memory pointer to the constant reg
 u32* _eeGetConstReg(int reg);
+bool _eeIsRegEntryValue(int reg);
 
 // finds where the GPR is stored and moves lower 32 bits to EAX
 void _eeMoveGPRtoR(x86IntRegType to, int fromgpr);
@@ -197,13 +197,12 @@ void recMTSAH( void )
 	**********************************************************/
 
 	// Suikoden 3 uses it a lot
-	void recCACHE() //Interpreter only!
+	// Without the data cache emulation there is nothing to write back or invalidate.  With it,
+	// the lines have to be handled by the interpreter, else dirty data stays in pCache.
+	void recCACHE()
 	{
-	   //MOV32ItoM( (uptr)&cpuRegs.code, (u32)cpuRegs.code );
-	   //MOV32ItoM( (uptr)&cpuRegs.pc, (u32)pc );
-	   //iFlushCall(FLUSH_EVERYTHING);
-	   //CALLFunc( (uptr)R5900::Interpreter::OpcodeImpl::CACHE );
-	   //branch = 2;
+		if (CHECK_CACHE)
+			recCall( R5900::Interpreter::OpcodeImpl::CACHE );
 	}
 
 	void recTGE( void )
@@ -34,3 +34,274 @@
 #include "iFPU.h"
 #include "iCOP0.h"
 
+
+////////////////////////////////////////////////
+// Back-Prob Function Tables - Gathering Info //
+////////////////////////////////////////////////
+// Only the per-instruction read/write lists are filled in here; the EEINST
+// liveness flags stay conservative.  The lists feed _recIsRegWritten and
+// _recIsRegRead, which the register allocator uses to pick spill victims.
+#define rpropSetRead(reg) { \
+	if( (reg) != 0 ) _recFillRegister(*pinst, XMMTYPE_GPRREG, reg, 0); \
+}
+
+#define rpropSetWrite(reg) { \
+	if( (reg) != 0 ) _recFillRegister(*pinst, XMMTYPE_GPRREG, reg, 1); \
+}
+
+static void rpropSPECIAL(EEINST* pinst);
+static void rpropREGIMM(EEINST* pinst);
+static void rpropCP0(EEINST* pinst);
+static void rpropCP1(EEINST* pinst);
+static void rpropCP2(EEINST* pinst);
+static void rpropMMI(EEINST* pinst);
+
+//SPECIAL, REGIMM, J    , JAL  , BEQ  , BNE , BLEZ , BGTZ ,
+//ADDI   , ADDIU , SLTI , SLTIU, ANDI , ORI , XORI , LUI  ,
+//COP0   , COP1  , COP2 , NULL , BEQL , BNEL, BLEZL, BGTZL,
+//DADDI  , DADDIU, LDL  , LDR  , MMI  , NULL, LQ   , SQ   ,
+//LB     , LH    , LWL  , LW   , LBU  , LHU , LWR  , LWU  ,
+//SB     , SH    , SWL  , SW   , SDL  , SDR , SWR  , CACHE,
+//NULL   , LWC1  , NULL , PREF , NULL , NULL, LQC2 , LD   ,
+//NULL   , SWC1  , NULL , NULL , NULL , NULL, SQC2 , SD
+void rpropBSC(EEINST* pinst)
+{
+	memset(pinst->writeType, XMMTYPE_TEMP, sizeof(pinst->writeType));
+	memset(pinst->readType, XMMTYPE_TEMP, sizeof(pinst->readType));
+
+	switch(_Opcode_) {
+		case 0: rpropSPECIAL(pinst); break;
+		case 1: rpropREGIMM(pinst); break;
+		case 2: // j
+			break;
+		case 3: // jal
+			rpropSetWrite(31);
+			break;
+
+		case 4: // beq
+		case 5: // bne
+		case 20: // beql
+		case 21: // bnel
+			rpropSetRead(_Rs_);
+			rpropSetRead(_Rt_);
+			break;
+
+		case 6: // blez
+		case 7: // bgtz
+		case 22: // blezl
+		case 23: // bgtzl
+			rpropSetRead(_Rs_);
+			break;
+
+		case 15: // lui
+			rpropSetWrite(_Rt_);
+			break;
+
+		case 16: rpropCP0(pinst); break;
+		case 17: rpropCP1(pinst); break;
+		case 18: rpropCP2(pinst); break;
+		case 28: rpropMMI(pinst); break;
+
+		case 26: // ldl
+		case 27: // ldr
+		case 34: // lwl
+		case 38: // lwr
+			// partial loads merge into the old value
+			rpropSetWrite(_Rt_);
+			rpropSetRead(_Rs_);
+			rpropSetRead(_Rt_);
+			break;
+
+		// stores
+		case 31: case 40: case 41: case 42: case 43: case 44: case 45: case 46: case 63:
+			rpropSetRead(_Rt_);
+			rpropSetRead(_Rs_);
+			break;
+
+		case 47: // cache
+		case 49: // lwc1
+		case 51: // pref
+		case 54: // lqc2
+		case 57: // swc1
+		case 62: // sqc2
+			rpropSetRead(_Rs_);
+			break;
+
+		case 8: case 9: case 10: case 11: case 12: case 13: case 14:
+		case 24: case 25: case 30: case 32: case 33: case 35: case 36:
+		case 37: case 39: case 55:
+			rpropSetWrite(_Rt_);
+			rpropSetRead(_Rs_);
+			break;
+
+		default:
+			break;
+	}
+}
+
+//SLL  , NULL , SRL  , SRA  , SLLV   , NULL , SRLV  , SRAV  ,
+//JR   , JALR , MOVZ , MOVN , SYSCALL, BREAK, NULL  , SYNC  ,
+//MFHI , MTHI , MFLO , MTLO , DSLLV  , NULL , DSRLV , DSRAV ,
+//MULT , MULTU, DIV  , DIVU , NULL   , NULL , NULL  , NULL  ,
+//ADD  , ADDU , SUB  , SUBU , AND    , OR   , XOR   , NOR   ,
+//MFSA , MTSA , SLT  , SLTU , DADD   , DADDU, DSUB  , DSUBU ,
+//TGE  , TGEU , TLT  , TLTU , TEQ    , NULL , TNE   , NULL  ,
+//DSLL , NULL , DSRL , DSRA , DSLL32 , NULL , DSRL32, DSRA32
+static void rpropSPECIAL(EEINST* pinst)
+{
+	switch(_Funct_) {
+		case 0: // sll
+		case 2: // srl
+		case 3: // sra
+		case 56: case 58: case 59: case 60: case 62: case 63: // dsll/dsrl/dsra(32)
+			rpropSetWrite(_Rd_);
+			rpropSetRead(_Rt_);
+			break;
+
+		case 8: // jr
+		case 41: // mtsa
+			rpropSetRead(_Rs_);
+			break;
+		case 9: // jalr
+			rpropSetWrite(_Rd_);
+			rpropSetRead(_Rs_);
+			break;
+
+		case 10: // movz
+		case 11: // movn
+			// conditional move keeps rd when the test fails
+			rpropSetWrite(_Rd_);
+			rpropSetRead(_Rs_);
+			rpropSetRead(_Rt_);
+			rpropSetRead(_Rd_);
+			break;
+
+		case 12: // syscall
+		case 13: // break
+		case 15: // sync
+			break;
+
+		case 16: // mfhi
+			rpropSetWrite(_Rd_);
+			rpropSetRead(XMMGPR_HI);
+			break;
+		case 17: // mthi
+			rpropSetWrite(XMMGPR_HI);
+			rpropSetRead(_Rs_);
+			break;
+		case 18: // mflo
+			rpropSetWrite(_Rd_);
+			rpropSetRead(XMMGPR_LO);
+			break;
+		case 19: // mtlo
+			rpropSetWrite(XMMGPR_LO);
+			rpropSetRead(_Rs_);
+			break;
+
+		case 24: // mult
+		case 25: // multu
+			// the EE also writes the low word to rd
+			rpropSetWrite(_Rd_);
+			// fall through
+		case 26: // div
+		case 27: // divu
+			rpropSetWrite(XMMGPR_LO);
+			rpropSetWrite(XMMGPR_HI);
+			rpropSetRead(_Rs_);
+			rpropSetRead(_Rt_);
+			break;
+
+		case 40: // mfsa
+			rpropSetWrite(_Rd_);
+			break;
+
+		case 48: case 49: case 50: case 51: case 52: case 54: // traps
+			rpropSetRead(_Rs_);
+			rpropSetRead(_Rt_);
+			break;
+
+		case 1: case 5: case 14: case 21: case 28: case 29: case 30: case 31:
+		case 53: case 55: case 57: case 61:
+			break;
+
+		default:
+			rpropSetWrite(_Rd_);
+			rpropSetRead(_Rs_);
+			rpropSetRead(_Rt_);
+			break;
+	}
+}
+
+//BLTZ  , BGEZ  , BLTZL  , BGEZL  , NULL , NULL , NULL , NULL,
+//TGEI  , TGEIU , TLTI   , TLTIU  , TEQI , NULL , TNEI , NULL,
+//BLTZAL, BGEZAL, BLTZALL, BGEZALL, NULL , NULL , NULL , NULL,
+//MTSAB , MTSAH , NULL   , NULL   , NULL , NULL , NULL , NULL
+static void rpropREGIMM(EEINST* pinst)
+{
+	switch(_Rt_) {
+		case 16: // bltzal
+		case 17: // bgezal
+		case 18: // bltzall
+		case 19: // bgezall
+			rpropSetWrite(31);
+			rpropSetRead(_Rs_);
+			break;
+
+		default:
+			rpropSetRead(_Rs_);
+			break;
+	}
+}
+
+static void rpropCP0(EEINST* pinst)
+{
+	switch(_Rs_) {
+		case 0: // mfc0
+			rpropSetWrite(_Rt_);
+			break;
+		case 4: // mtc0
+			rpropSetRead(_Rt_);
+			break;
+	}
+}
+
+static void rpropCP1(EEINST* pinst)
+{
+	switch(_Rs_) {
+		case 0: // mfc1
+		case 2: // cfc1
+			rpropSetWrite(_Rt_);
+			break;
+		case 4: // mtc1
+		case 6: // ctc1
+			rpropSetRead(_Rt_);
+			break;
+	}
+}
+
+static void rpropCP2(EEINST* pinst)
+{
+	switch(_Rs_) {
+		case 1: // qmfc2
+		case 2: // cfc2
+			rpropSetWrite(_Rt_);
+			break;
+		case 5: // qmtc2
+		case 6: // ctc2
+			rpropSetRead(_Rt_);
+			break;
+	}
+}
+
+// MMI ops are not decoded individually: assume every one of them reads rs, rt
+// and HI/LO, and writes rd and HI/LO.
+static void rpropMMI(EEINST* pinst)
+{
+	rpropSetWrite(_Rd_);
+	rpropSetWrite(XMMGPR_HI);
+	rpropSetWrite(XMMGPR_LO);
+	rpropSetRead(_Rs_);
+	rpropSetRead(_Rt_);
+	rpropSetRead(XMMGPR_HI);
+	rpropSetRead(XMMGPR_LO);
+}
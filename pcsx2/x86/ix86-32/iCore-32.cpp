@@ -511,15 +511,21 @@ int  _getFreeMMXreg()
 		}
 	}
 
-	// check for future xmm usage
+	// spill the gpr that is read again furthest away (see recompileNextInstruction)
 	for (i=0; i<iREGCNT_MMX; i++) {
 		if (mmxregs[i].needed) continue;
-		if (MMX_ISGPR(mmxregs[i].reg)) {
-			_freeMMXreg(i);
-			return i;
+		if (MMX_ISGPR(mmxregs[i].reg) && mmxregs[i].counter < bestcount) {
+			tempi = i;
+			bestcount = mmxregs[i].counter;
 		}
 	}
 
+	if( tempi != -1 ) {
+		g_recRegStats.spills++;
+		_freeMMXreg(tempi);
+		return tempi;
+	}
+
 	for (i=0; i<iREGCNT_MMX; i++) {
 		if (mmxregs[i].needed) continue;
 		if (mmxregs[i].reg != MMX_TEMP) {
@@ -536,6 +542,7 @@ int  _getFreeMMXreg()
 	}
 
 	if( tempi != -1 ) {
+		g_recRegStats.spills++;
 		_freeMMXreg(tempi);
 		return tempi;
 	}
@@ -31,6 +31,9 @@
 #include "GS.h"
 #include "CDVD/CDVD.h"
 #include "Elfheader.h"
+#include "Counters.h"
+
+#include <algorithm>
 
 #if !PCSX2_SEH
 #	include <csetjmp>
@@ -106,6 +109,56 @@ static BASEBLOCKEX* s_pCurBlockEx = NULL;
 u32 s_nEndBlock = 0; // what pc the current block ends
 u32 s_branchTo;
 static bool s_nBlockFF;
+static bool s_recDeferred = false;	// compiling from the deferred queue, cpuRegs belongs to another pc
+
+// Wait loops found by the block analysis, reported per game when the recompiler is reset.
+// The fast-forward code of the loop updates its entry.
+struct WaitLoopStats
+{
+	u64 cycles;		// EE cycles skipped
+	u32 count;		// times the loop was fast-forwarded
+	u32 pc;
+};
+
+static WaitLoopStats s_waitLoops[64];
+static int s_nWaitLoops = 0;
+static WaitLoopStats* s_pWaitLoop = NULL;
+
+// Predicted targets of JR/JALR exits.  JAL/JALR push their return address on a small ring
+// stack which JR $ra pops, other register jumps remember the last target of the site.  Sites
+// are picked by the pc of the jump, so a recompiled block reuses its site; jumps sharing a
+// site only cost misses.  A guessed target is reached through its BASEBLOCK, so cleared
+// blocks still go to JITCompile.
+struct BranchTarget
+{
+	u32 pc;
+	uptr slot;		// BASEBLOCK of pc
+};
+
+C_ASSERT( sizeof(BranchTarget) == 8 );	// indexed with *8 by the recompiled code
+
+enum BranchPredictType
+{
+	BranchPredict_None = 0,
+	BranchPredict_Return,
+	BranchPredict_Site,
+};
+
+static const int RETURN_STACK_SIZE = 16;
+static const int BRANCH_SITE_COUNT = 16384;
+
+static BASEBLOCK s_dispatcherSlot;		// target of empty entries, leads to DispatcherReg
+static __aligned16 BranchTarget s_returnStack[RETURN_STACK_SIZE];
+static u32 s_returnTop = 0;
+static BranchTarget s_branchSites[BRANCH_SITE_COUNT];
+
+static u32 s_branchReturn = 0;			// return address pushed at the end of the current block
+static BranchPredictType s_branchPredict = BranchPredict_None;
+static BranchTarget* s_pBranchSite = NULL;
+
+// time spent in recRecompile, to estimate what keeping blocks over a write fault saves
+static u64 s_recompileTicks = 0;
+static u32 s_recompileCount = 0;
 
 // save states for branches
 GPR_reg64 s_saveConstRegs[32];
@@ -165,6 +218,17 @@ u32* _eeGetConstReg(int reg)
 	return &cpuRegs.GPR.r[ reg ].UL[0];
 }
 
+// Returns true if no earlier instruction of the block writes the gpr, meaning cpuRegs
+// holds the value the gpr will have at the current instruction on the block's first run
+// (blocks are recompiled right before they execute, except those of the deferred queue).
+bool _eeIsRegEntryValue(int reg)
+{
+	if( s_recDeferred || !EmuConfig.Cpu.Recompiler.EERegLiveness ) return false;
+
+	// the entry for instruction k is s_pInstCache[k+1]
+	return !_recIsRegWritten(s_pInstCache+1, g_pCurInstInfo - (s_pInstCache+1), XMMTYPE_GPRREG, reg);
+}
+
 void _eeMoveGPRtoR(x86IntRegType to, int fromgpr)
 {
 	if( fromgpr == 0 )
@@ -362,6 +426,17 @@ static void __fastcall recRecompile( const u32 startpc );
 
 static u32 s_store_ebp, s_store_esp;
 
+// sceMpegIsEnd: lw reg, 0x40(a0); jr ra; lw v0, 0(reg)
+static bool isMpegIsEndPattern(u32 sPC)
+{
+	if (memRead32(sPC + 4) != 0x03e00008) return false;
+
+	u32 code = memRead32(sPC);
+	u32 p1   = 0x8c800040;
+	u32 p2	 = 0x8c020000 | (code & 0x1f0000) << 5;
+	return ((code & 0xffe0ffff) == p1) && (memRead32(sPC+8) == p2);
+}
+
 // Recompiled code buffer for EE recompiler dispatchers!
 static u8 __pagealigned eeRecDispatchers[__pagesize];
 
@@ -371,12 +446,97 @@ static DynGenFunc* DispatcherEvent		= NULL;
 static DynGenFunc* DispatcherReg		= NULL;
 static DynGenFunc* JITCompile			= NULL;
 static DynGenFunc* JITCompileInBlock	= NULL;
+static DynGenFunc* JITInterpret			= NULL;
 static DynGenFunc* EnterRecompiledCode	= NULL;
 static DynGenFunc* ExitRecompiledCode	= NULL;
 
+// Deferred compiles (EEDeferCompile): JITCompile queues a new block and points it to
+// JITInterpret, which runs it with the interpreter until recEventTest gets to compile it.
+// The queue gets a fixed share of each frame so that code-heavy loads don't stall the EE.
+// Until then the block misses what only the recompiled code does: wait loops are not
+// fast-forwarded, and the blocks of the sceMpegIsEnd gamefix are never deferred.
+static const int DEFER_QUEUE_SIZE = 1024;
+
+static u32 s_deferQueue[DEFER_QUEUE_SIZE];
+static int s_deferHead = 0;
+static int s_nDeferred = 0;
+static uint s_deferFrame = 0;
+static u64 s_deferTicks = 0;		// compile time spent in s_deferFrame
+
+static bool recCanDefer( u32 startpc )
+{
+	if( !EmuConfig.Cpu.Recompiler.EEDeferCompile || EmuConfig.Cpu.Recompiler.PreBlockCheckEE )
+		return false;
+
+	// these blocks carry hooks which only the recompiled code calls
+	if( HWADDR(startpc) == ElfEntry || (g_SkipBiosHack && HWADDR(startpc) == EELOAD_START) )
+		return false;
+
+	if( CHECK_SKIPMPEGHACK && isMpegIsEndPattern(startpc) )
+		return false;
+
+	return s_nDeferred < DEFER_QUEUE_SIZE;
+}
+
+// Linked jumps to a queued block still lead here, see that it is only queued once.
+static void __fastcall recJITCompile( const u32 startpc )
+{
+	if( PC_GETBLOCK(startpc)->GetFnptr() == (uptr)JITInterpret ) return;
+
+	if( !recCanDefer( startpc ) )
+	{
+		recRecompile( startpc );
+		return;
+	}
+
+	s_deferQueue[(s_deferHead + s_nDeferred) % DEFER_QUEUE_SIZE] = startpc;
+	s_nDeferred++;
+	PC_GETBLOCK(startpc)->SetFnptr( (uptr)JITInterpret );
+
+	eeJitStats.queued++;
+	eeJitStats.maxDepth = std::max<u32>( eeJitStats.maxDepth, s_nDeferred );
+}
+
+static void recInterpretBlock()
+{
+	eeJitStats.interpreted += intExecuteBlock();
+}
+
+// Blocks that were cleared or compiled since they were queued don't point to JITInterpret
+// anymore and are dropped.
+static void recCompileDeferred()
+{
+	if( s_deferFrame != g_FrameCount )
+	{
+		s_deferFrame = g_FrameCount;
+		s_deferTicks = 0;
+	}
+
+	const u64 budget = GetTickFrequency() / 500;	// 2ms a frame
+
+	while( s_nDeferred > 0 && s_deferTicks < budget )
+	{
+		const u32 startpc = s_deferQueue[s_deferHead];
+		s_deferHead = (s_deferHead + 1) % DEFER_QUEUE_SIZE;
+		s_nDeferred--;
+
+		if( PC_GETBLOCK(startpc)->GetFnptr() != (uptr)JITInterpret ) continue;
+
+		const u64 start = GetCPUTicks();
+		s_recDeferred = true;
+		recRecompile( startpc );
+		s_recDeferred = false;
+		s_deferTicks += GetCPUTicks() - start;
+
+		eeJitStats.compiled++;
+	}
+}
+
 static void recEventTest()
 {
 	_cpuEventTest_Shared();
+
+	if( s_nDeferred > 0 ) recCompileDeferred();
 }
 
 // parameters:
@@ -433,7 +593,7 @@ static DynGenFunc* _DynGen_JITCompile()
 	_DynGen_StackFrameCheck();
 
 	xMOV( ecx, ptr[&cpuRegs.pc] );
-	xCALL( recRecompile );
+	xCALL( recJITCompile );
 
 	xMOV( eax, ptr[&cpuRegs.pc] );
 	xMOV( ebx, eax );
@@ -451,12 +611,31 @@ static DynGenFunc* _DynGen_JITCompileInBlock()
 	return (DynGenFunc*)retval;
 }
 
+// The address of blocks queued for compiling.  Interprets up to the next branch and then
+// dispatches like the end of a recompiled block.
+static DynGenFunc* _DynGen_JITInterpret()
+{
+	u8* retval = xGetAlignedCallTarget();
+	_DynGen_StackFrameCheck();
+
+	xCALL( recInterpretBlock );
+
+	xMOV( eax, ptr[&cpuRegs.cycle] );
+	xSUB( eax, ptr[&g_nextEventCycle] );
+	xJS( DispatcherReg );
+	xJMP( DispatcherEvent );
+
+	return (DynGenFunc*)retval;
+}
+
 // called when jumping to variable pc address
 static DynGenFunc* _DynGen_DispatcherReg()
 {
 	u8* retval = xGetPtr();		// fallthrough target, can't align it!
 	_DynGen_StackFrameCheck();
 
+	xINC( ptr32[&eeBranchStats.dispatched] );
+
 	xMOV( eax, ptr[&cpuRegs.pc] );
 	xMOV( ebx, eax );
 	xSHR( eax, 16 );
@@ -547,17 +726,19 @@ static void _DynGen_Dispatchers()
 
 	JITCompile			= _DynGen_JITCompile();
 	JITCompileInBlock	= _DynGen_JITCompileInBlock();
+	JITInterpret		= _DynGen_JITInterpret();
 	EnterRecompiledCode	= _DynGen_EnterRecompiledCode();
 
 	HostSys::MemProtectStatic( eeRecDispatchers, PageAccess_ExecOnly() );
 
+	s_dispatcherSlot.SetFnptr( (uptr)DispatcherReg );
+
 	recBlocks.SetJITCompile( JITCompile );
 }
 
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //
-static void __fastcall dyna_block_discard(u32 start,u32 sz);
 
 static __ri void ClearRecLUT(BASEBLOCK* base, int memsize)
 {
@@ -699,6 +880,115 @@ static u32 eeRecNeedsReset = false;
 static bool eeCpuExecuting = false;
 
 ////////////////////////////////////////////////////
+static bool recWaitLoopCompare( const WaitLoopStats& a, const WaitLoopStats& b )
+{
+	return a.cycles > b.cycles;
+}
+
+static void recReportWaitLoops()
+{
+	if( s_nWaitLoops == 0 ) return;
+
+	u64 cycles = 0;
+
+	for( int i = 0; i < s_nWaitLoops; i++ )
+		cycles += s_waitLoops[i].cycles;
+
+	std::sort( s_waitLoops, s_waitLoops + s_nWaitLoops, recWaitLoopCompare );
+
+	Console.WriteLn( "EE wait loops (CRC %08X): %d detected, %llu cycles skipped", ElfCRC, s_nWaitLoops, cycles );
+
+	for( int i = 0; i < std::min( s_nWaitLoops, 8 ); i++ )
+	{
+		if( s_waitLoops[i].count == 0 ) continue;
+
+		Console.Indent().WriteLn( "%08x: %u times, %llu cycles", s_waitLoops[i].pc, s_waitLoops[i].count, s_waitLoops[i].cycles );
+	}
+
+	memzero( s_waitLoops );
+	s_nWaitLoops = 0;
+}
+
+static void recReportRegStats()
+{
+	if( s_recompileCount > 0 )
+	{
+		Console.WriteLn( "EE register allocation (CRC %08X): %u blocks, %u spills, %u flushes at calls",
+			ElfCRC, s_recompileCount, g_recRegStats.spills, g_recRegStats.flushes );
+	}
+
+	memzero( g_recRegStats );
+}
+
+static void recReportCop2Stats()
+{
+	if( g_recCop2Stats.flushes > 0 || g_recCop2Stats.macFlags > 0 )
+	{
+		Console.WriteLn( "EE COP2 macro ops (CRC %08X): %u VU0 register flushes and %u Mac flag updates skipped",
+			ElfCRC, g_recCop2Stats.flushes, g_recCop2Stats.macFlags );
+	}
+
+	memzero( g_recCop2Stats );
+}
+
+static void recReportSpecStats()
+{
+	const vtlb_SpecStats& stats = vtlb_specStats;
+
+	if( stats.sites > 0 )
+	{
+#ifdef PCSX2_DEVBUILD
+		Console.WriteLn( "EE guessed-page accesses (CRC %08X): %u sites, %u hits, %u misses",
+			ElfCRC, stats.sites, stats.hits, stats.misses );
+#else
+		Console.WriteLn( "EE guessed-page accesses (CRC %08X): %u sites, %u misses",
+			ElfCRC, stats.sites, stats.misses );
+#endif
+	}
+
+	memzero( vtlb_specStats );
+}
+
+static void recReportSmcStats()
+{
+	const mmap_SmcStats& stats = mmap_smcStats;
+
+	if( stats.faults > 0 || stats.invalidated > 0 || stats.checkedWords > 0 )
+	{
+		Console.WriteLn( "EE code writes (CRC %08X): %u page faults (%u into data lines), %u blocks invalidated, %u pages re-protected",
+			ElfCRC, stats.faults, stats.dataFaults, stats.invalidated, stats.reprotected );
+		Console.Indent().WriteLn( "%u blocks kept instead of recompiled, ~%llu ticks saved", stats.blocksKept, stats.ticksSaved );
+		Console.Indent().WriteLn( "code checks: %u calls from kept blocks, %llu words compared inline", stats.checkCalls, stats.checkedWords );
+	}
+
+	memzero( mmap_smcStats );
+	s_recompileTicks = 0;
+	s_recompileCount = 0;
+}
+
+static void recResetBranchTargets()
+{
+	for( int i = 0; i < RETURN_STACK_SIZE; i++ )
+	{
+		s_returnStack[i].pc = 0;
+		s_returnStack[i].slot = (uptr)&s_dispatcherSlot;
+	}
+
+	for( int i = 0; i < BRANCH_SITE_COUNT; i++ )
+	{
+		s_branchSites[i].pc = 0;
+		s_branchSites[i].slot = (uptr)&s_dispatcherSlot;
+	}
+
+	s_returnTop = 0;
+}
+
+static void recResetDeferred()
+{
+	s_deferHead = 0;
+	s_nDeferred = 0;
+}
+
 static void recResetRaw()
 {
 	recAlloc();
@@ -708,6 +998,12 @@ static void recResetRaw()
 
 	Console.WriteLn( Color_StrongBlack, "EE/iR5900-32 Recompiler Reset" );
 
+	recReportWaitLoops();
+	recReportRegStats();
+	recReportCop2Stats();
+	recReportSpecStats();
+	recReportSmcStats();
+
 	recMem->Reset();
 	recRAMCopy->Reset();
 	recLutReserve_RAM->Reset();
@@ -721,6 +1017,8 @@ static void recResetRaw()
 
 	recBlocks.Reset();
 	mmap_ResetBlockTracking();
+	recResetBranchTargets();
+	recResetDeferred();
 
 	x86SetPtr(*recMem);
 
@@ -733,6 +1031,12 @@ static void recResetRaw()
 
 static void recShutdown()
 {
+	recReportWaitLoops();
+	recReportRegStats();
+	recReportCop2Stats();
+	recReportSpecStats();
+	recReportSmcStats();
+
 	safe_delete( recMem );
 	safe_delete( recRAMCopy );
 	safe_delete( recLutReserve_RAM );
@@ -944,6 +1248,86 @@ void recClear(u32 addr, u32 size)
 
 static int *s_pCode;
 
+// Called by JAL/JALR: the block end pushes retpc on the return stack.
+void SetBranchReturn( u32 retpc )
+{
+	s_branchReturn = retpc;
+}
+
+// Emitted after the block flush, eax and ecx are free.
+static void recPushReturn()
+{
+	if( !s_branchReturn ) return;
+
+	xMOV( eax, ptr32[&s_returnTop] );
+	xMOV( ptr32[&s_returnStack[0].pc + eax*8], s_branchReturn );
+	xMOV( ptr32[&s_returnStack[0].slot + eax*8], (uptr)PC_GETBLOCK(s_branchReturn) );
+	xINC( eax );
+	xAND( eax, RETURN_STACK_SIZE - 1 );
+	xMOV( ptr32[&s_returnTop], eax );
+
+	s_branchReturn = 0;
+}
+
+// Picks how iBranchTest guesses the target of a register jump.  The return stack is
+// popped before the event test so that it stays balanced when the event path is taken.
+static void recSetBranchPredict( u32 reg )
+{
+	if( reg == 31 )
+	{
+		xMOV( eax, ptr32[&s_returnTop] );
+		xDEC( eax );
+		xAND( eax, RETURN_STACK_SIZE - 1 );
+		xMOV( ptr32[&s_returnTop], eax );
+
+		s_branchPredict = BranchPredict_Return;
+	}
+	else
+	{
+		s_pBranchSite = &s_branchSites[(pc >> 2) & (BRANCH_SITE_COUNT - 1)];
+		s_branchPredict = BranchPredict_Site;
+	}
+}
+
+// Jumps straight to the guessed block when cpuRegs.pc matches it, DispatcherReg otherwise.
+// A site remembers the target it missed on.
+static void recPredictBranch()
+{
+	xMOV( eax, ptr32[&cpuRegs.pc] );
+
+	if( s_branchPredict == BranchPredict_Return )
+	{
+		xMOV( ecx, ptr32[&s_returnTop] );
+		xCMP( eax, ptr32[&s_returnStack[0].pc + ecx*8] );
+		xForwardJNE8 miss;
+		if( IsDevBuild ) xINC( ptr32[&eeBranchStats.hits] );
+		xMOV( ecx, ptr32[&s_returnStack[0].slot + ecx*8] );
+		xJMP( ptr32[ecx] );
+		miss.SetTarget();
+
+		xINC( ptr32[&eeBranchStats.misses] );
+	}
+	else
+	{
+		xCMP( eax, ptr32[&s_pBranchSite->pc] );
+		xForwardJNE8 miss;
+		if( IsDevBuild ) xINC( ptr32[&eeBranchStats.hits] );
+		xMOV( ecx, ptr32[&s_pBranchSite->slot] );
+		xJMP( ptr32[ecx] );
+		miss.SetTarget();
+
+		xINC( ptr32[&eeBranchStats.misses] );
+		xMOV( ptr32[&s_pBranchSite->pc], eax );
+		xMOV( ecx, eax );
+		xSHR( ecx, 16 );
+		xMOV( ecx, ptr[recLUT + (ecx*4)] );
+		xADD( ecx, eax );
+		xMOV( ptr32[&s_pBranchSite->slot], ecx );
+	}
+
+	xJMP( DispatcherReg );
+}
+
 void SetBranchReg( u32 reg )
 {
 	branch = 1;
@@ -989,6 +1373,9 @@ void SetBranchReg( u32 reg )
 
 	iFlushCall(FLUSH_EVERYTHING);
 
+	recPushReturn();
+	recSetBranchPredict(reg);
+
 	iBranchTest();
 }
 
@@ -1000,6 +1387,7 @@ void SetBranchImm( u32 imm )
 
 	// end the current block
 	iFlushCall(FLUSH_EVERYTHING);
+	recPushReturn();
 	xMOV(ptr32[&cpuRegs.pc], imm);
 	iBranchTest(imm);
 }
@@ -1056,13 +1444,19 @@ void iFlushCall(int flushtype)
 		g_maySignalException = true;
 	}
 
-	if( flushtype & FLUSH_FREE_XMM )
+	if( flushtype & FLUSH_FREE_XMM ) {
+		for (int i = 0; i < iREGCNT_XMM; ++i)
+			if (xmmregs[i].inuse && xmmregs[i].type != XMMTYPE_TEMP) g_recRegStats.flushes++;
 		_freeXMMregs();
+	}
 	else if( flushtype & FLUSH_FLUSH_XMM)
 		_flushXMMregs();
 
-	if( flushtype & FLUSH_FREE_MMX )
+	if( flushtype & FLUSH_FREE_MMX ) {
+		for (int i = 0; i < iREGCNT_MMX; ++i)
+			if (mmxregs[i].inuse && mmxregs[i].reg != MMX_TEMP) g_recRegStats.flushes++;
 		_freeMMXregs();
+	}
 	else if( flushtype & FLUSH_FLUSH_MMX)
 		_flushMMXregs();
 
@@ -1168,6 +1562,16 @@ static void iBranchTest(u32 newpc)
 		xADD(ptr32[&cpuRegs.cycle], eeScaleBlockCycles());
 		xCMP(eax, ptr32[&cpuRegs.cycle]);
 		xCMOVS(eax, ptr32[&cpuRegs.cycle]);
+
+		if (s_pWaitLoop)
+		{
+			xMOV(edx, eax);
+			xSUB(edx, ptr32[&cpuRegs.cycle]);
+			xADD(ptr32[&s_pWaitLoop->cycles], edx);
+			xADC(ptr32[(u32*)&s_pWaitLoop->cycles + 1], 0);
+			xINC(ptr32[&s_pWaitLoop->count]);
+		}
+
 		xMOV(ptr32[&cpuRegs.cycle], eax);
 
 		xJMP( DispatcherEvent );
@@ -1179,13 +1583,22 @@ static void iBranchTest(u32 newpc)
 		xMOV(ptr[&cpuRegs.cycle], eax); // update cycles
 		xSUB(eax, ptr[&g_nextEventCycle]);
 
-		if (newpc == 0xffffffff)
+		if (newpc == 0xffffffff && s_branchPredict != BranchPredict_None)
+		{
+			xForwardJNS32 event;
+			recPredictBranch();
+			event.SetTarget();
+		}
+		else if (newpc == 0xffffffff)
 			xJS( DispatcherReg );
 		else
 			recBlocks.Link(HWADDR(newpc), xJcc32(Jcc_Signed));
 
 		xJMP( DispatcherEvent );
 	}
+
+	s_branchPredict = BranchPredict_None;
+	s_pBranchSite = NULL;
 }
 
 void recompileNextInstruction(int delayslot)
@@ -1211,10 +1624,13 @@ void recompileNextInstruction(int delayslot)
 
 	g_pCurInstInfo++;
 
+	// Spill priority: the lower the counter, the further away the next read.
+	// Registers that are overwritten before being read again (or not read again
+	// in this block) get 0 and are the first to go.
 	for(i = 0; i < iREGCNT_MMX; ++i) {
 		if( mmxregs[i].inuse ) {
 			pxAssert( MMX_ISGPR(mmxregs[i].reg) );
-			count = _recIsRegWritten(g_pCurInstInfo, (s_nEndBlock-pc)/4 + 1, XMMTYPE_GPRREG, mmxregs[i].reg-MMX_GPR);
+			count = _recIsRegRead(g_pCurInstInfo, (s_nEndBlock-pc)/4 + 1, XMMTYPE_GPRREG, mmxregs[i].reg-MMX_GPR);
 			if( count > 0 ) mmxregs[i].counter = 1000-count;
 			else mmxregs[i].counter = 0;
 		}
@@ -1222,7 +1638,7 @@ void recompileNextInstruction(int delayslot)
 
 	for(i = 0; i < iREGCNT_XMM; ++i) {
 		if( xmmregs[i].inuse ) {
-			count = _recIsRegWritten(g_pCurInstInfo, (s_nEndBlock-pc)/4 + 1, xmmregs[i].type, xmmregs[i].reg);
+			count = _recIsRegRead(g_pCurInstInfo, (s_nEndBlock-pc)/4 + 1, xmmregs[i].type, xmmregs[i].reg);
 			if( count > 0 ) xmmregs[i].counter = 1000-count;
 			else xmmregs[i].counter = 0;
 		}
@@ -1300,10 +1716,17 @@ void recompileNextInstruction(int delayslot)
 
 	g_maySignalException = false;
 
-	if (!delayslot && (xGetPtr() - recPtr > 0x1000) )
+	// A run of COP2 macro ops that keeps the VU0 regs cached can't be cut in the middle, the
+	// op following it has to write them back (it stops the run once the block is full).
+	if (!delayslot && !mVUmacroCached() && recBlockCodeFull())
 		s_nEndBlock = pc;
 }
 
+bool recBlockCodeFull()
+{
+	return xGetPtr() - recPtr > 0x1000;
+}
+
 // (Called from recompiled code)]
 // This function is called from the recompiler prior to starting execution of *every* recompiled block.
 // Calling of this function can be enabled or disabled through the use of EmuConfig.Recompiler.PreBlockChecks
@@ -1331,38 +1754,185 @@ static void __fastcall PreBlockCheck( u32 blockpc )
 static u32 s_recblocks[] = {0};
 #endif
 
-// Called when a block under manual protection fails it's pre-execution integrity check.
-// (meaning the actual code area has been modified -- ie dynamic modules being loaded or,
-//  less likely, self-modifying code)
-void __fastcall dyna_block_discard(u32 start,u32 sz)
+// Called when a block of a manual page fails its inline code check (meaning the actual code
+// area has been modified -- ie dynamic modules being loaded or, less likely, self-modifying code)
+static void __fastcall dyna_block_discard(u32 start, u32 sz)
 {
 	eeRecPerfLog.Write( Color_StrongGray, "Clearing Manual Block @ 0x%08X  [size=%d]", start, sz*4);
 	recClear(start, sz);
+	mmap_smcStats.invalidated++;
+}
 
-	// Stack trick: This function was invoked via a direct jmp, so manually pop the
-	// EBP/stackframe before issuing a RET, else esp/ebp will be incorrect.
+static void recSetBlockChecking(int idx, bool checking)
+{
+	BASEBLOCKEX* pexblock = recBlocks[idx];
 
-#ifdef _MSC_VER
-	__asm leave __asm jmp [ExitRecompiledCode]
-#else
-	__asm__ __volatile__( "leave\n jmp *%[exitRec]\n" : : [exitRec] "m" (ExitRecompiledCode) : );
-#endif
+	recBlocks.SetChecking(idx, checking);
+	PC_GETBLOCK(pexblock->startpc)->SetFnptr(pexblock->GetEntry());
 }
 
-// called when a page under manual protection has been run enough times to be a candidate
-// for being reset under the faster vtlb write protection.  All blocks in the page are cleared
-// and the block is re-assigned for write protection.
-void __fastcall dyna_page_reset(u32 start,u32 sz)
+// Called when a page under manual protection has been run enough times to be a candidate for
+// being reset under the faster vtlb write protection.  Blocks recompiled before the page lost
+// its protection are verified and, if intact, go back to their unchecked entry.  The changed
+// ones and the ones checking their code inline are cleared.  Returns true if the whole page
+// had to be cleared.
+static bool __fastcall dyna_page_reprotect(u32 start)
 {
-	recClear(start & ~0xfffUL, 0x400);
-	manual_counter[start >> 12]++;
-	mmap_MarkCountedRamPage( start );
+	u32 page = start >> 12;
+	u32 first = start & ~0xfff;
+	u32 cleared[64], clearedSize[64];
+	int count = 0, changed = 0, kept = 0;
+	bool overflow = false;
 
-#ifdef _MSC_VER
-	__asm leave __asm jmp [ExitRecompiledCode]
-#else
-	__asm__ __volatile__( "leave\n jmp *%[exitRec]\n" : : [exitRec] "m" (ExitRecompiledCode) : );
-#endif
+	manual_counter[page]++;
+
+	for (int i = recBlocks.LastIndex(first + 0xffc); BASEBLOCKEX* pexblock = recBlocks[i]; i--)
+	{
+		if (pexblock->startpc < first)
+			break;
+
+		bool intact = memcmp(&(*recRAMCopy)[pexblock->startpc / 4], PSM(pexblock->startpc), pexblock->size * 4) == 0;
+
+		if (intact && pexblock->checkfn)
+		{
+			if (pexblock->checking) recSetBlockChecking(i, false);
+			kept++;
+			continue;
+		}
+
+		if (!intact) changed++;
+
+		if (count < (int)ArraySize(cleared))
+		{
+			cleared[count] = pexblock->startpc;
+			clearedSize[count++] = pexblock->size;
+		}
+		else
+		{
+			overflow = true;
+		}
+	}
+
+	if (overflow)
+	{
+		// too many blocks to clear one by one, clear the whole page
+		recClear(first, 0x400);
+		kept = 0;
+	}
+	else
+	{
+		for (int i = 0; i < count; i++)
+			recClear(cleared[i], clearedSize[i]);
+	}
+
+	eeRecPerfLog.Write( "Re-protecting page @ 0x%05x: %d blocks kept, %d changed", page, kept, changed );
+
+	mmap_MarkCountedRamPage(start);
+
+	mmap_smcStats.reprotected++;
+	mmap_smcStats.invalidated += changed;
+	mmap_smcStats.blocksKept += kept;
+
+	if (s_recompileCount > 0)
+		mmap_smcStats.ticksSaved += kept * (s_recompileTicks / s_recompileCount);
+
+	return overflow;
+}
+
+// Checking entry of a block recompiled while its page was write protected, used once the
+// page loses its protection (see recSelfCheckPage).  The code of the block is compared with
+// the copy it was recompiled from, a changed block is discarded.  Returns true if the block
+// was discarded, the recompiled code has to be left then.
+static bool __fastcall dyna_block_check(u32 start, u32 sz)
+{
+	mmap_smcStats.checkCalls++;
+
+	if (memcmp(&(*recRAMCopy)[start / 4], PSM(start), sz * 4))
+	{
+		dyna_block_discard(start, sz);
+		return true;
+	}
+
+	u32 page = start >> 12;
+
+	if (start == 0x81fc0)
+		return false;
+
+	// The page stays under manual protection for good: recompile the block with the cheaper
+	// inline check instead of calling in here every time.
+
+	if (manual_counter[page] > 3)
+	{
+		recClear(start, sz);
+		return true;
+	}
+
+	// Blocks add a weighted (by block size) value into manual_page each time they're run.  If the
+	// page gets run a lot, it is re-protected in the hope that whatever caused the fault was a
+	// 1-time deal.
+
+	manual_page[page] += sz;
+
+	if (manual_page[page] >= sz)
+		return false;
+
+	return dyna_page_reprotect(start);
+}
+
+// Called by the page fault handler when a page holding recompiled blocks loses its write
+// protection.  The blocks overlapping the 128 byte line being written are discarded, the
+// others are kept and enter through their code check from now on.  Blocks recompiled while
+// the page was already under manual protection check their code inline and are left alone.
+void recSelfCheckPage(u32 paddr, int line)
+{
+	u32 first = paddr & ~0xfff;
+	u32 lineStart = first + line * 128;
+	u32 cleared[64], clearedSize[64];
+	int count = 0, kept = 0;
+	bool overflow = false;
+
+	for (int i = recBlocks.LastIndex(first + 0xffc); BASEBLOCKEX* pexblock = recBlocks[i]; i--)
+	{
+		if (pexblock->startpc < first)
+			break;
+
+		if (!pexblock->checkfn)
+			continue;
+
+		u32 blockend = pexblock->startpc + pexblock->size * 4;
+
+		if (line < 0 || blockend <= lineStart || pexblock->startpc >= lineStart + 128)
+		{
+			if (!pexblock->checking) recSetBlockChecking(i, true);
+			kept++;
+		}
+		else if (count < (int)ArraySize(cleared))
+		{
+			cleared[count] = pexblock->startpc;
+			clearedSize[count++] = pexblock->size;
+		}
+		else
+		{
+			overflow = true;
+		}
+	}
+
+	if (overflow)
+	{
+		recClear(first, 0x400);
+		kept = 0;
+	}
+	else
+	{
+		for (int i = 0; i < count; i++)
+			recClear(cleared[i], clearedSize[i]);
+	}
+
+	mmap_smcStats.invalidated += count;
+	mmap_smcStats.blocksKept += kept;
+
+	if (s_recompileCount > 0)
+		mmap_smcStats.ticksSaved += kept * (s_recompileTicks / s_recompileCount);
 }
 
 // Skip MPEG Game-Fix
@@ -1370,13 +1940,7 @@ bool skipMPEG_By_Pattern(u32 sPC) {
 
 	if (!CHECK_SKIPMPEGHACK) return 0;
 
-	// sceMpegIsEnd: lw reg, 0x40(a0); jr ra; lw v0, 0(reg)
-	if ((s_nEndBlock == sPC + 12) && (memRead32(sPC + 4) == 0x03e00008)) {
-		u32 code = memRead32(sPC);
-		u32 p1   = 0x8c800040;
-		u32 p2	 = 0x8c020000 | (code & 0x1f0000) << 5;
-		if ((code & 0xffe0ffff)   != p1) return 0;
-		if (memRead32(sPC+8) != p2) return 0;
+	if ((s_nEndBlock == sPC + 12) && isMpegIsEndPattern(sPC)) {
 		xMOV(ptr32[&cpuRegs.GPR.n.v0.UL[0]], 1);
 		xMOV(ptr32[&cpuRegs.GPR.n.v0.UL[1]], 0);
 		xMOV(eax, ptr32[&cpuRegs.GPR.n.ra.UL[0]]);
@@ -1413,6 +1977,11 @@ static void __fastcall recRecompile( const u32 startpc )
 
 	if (eeRecNeedsReset) recResetRaw();
 
+	const u64 recompileStart = GetCPUTicks();
+	const RecRegStats regStart = g_recRegStats;
+	const RecCop2Stats cop2Start = g_recCop2Stats;
+	mVUmacroReset();
+
 	xSetPtr( recPtr );
 	recPtr = xGetAlignedCallTarget();
 
@@ -1422,7 +1991,8 @@ static void __fastcall recRecompile( const u32 startpc )
 	s_pCurBlock = PC_GETBLOCK(startpc);
 
 	pxAssert(s_pCurBlock->GetFnptr() == (uptr)JITCompile
-		|| s_pCurBlock->GetFnptr() == (uptr)JITCompileInBlock);
+		|| s_pCurBlock->GetFnptr() == (uptr)JITCompileInBlock
+		|| s_pCurBlock->GetFnptr() == (uptr)JITInterpret);
 
 	s_pCurBlockEx = recBlocks.Get(HWADDR(startpc));
 	pxAssert(!s_pCurBlockEx || s_pCurBlockEx->startpc != HWADDR(startpc));
@@ -1638,6 +2208,21 @@ StartRecomp:
 		}
 	}
 
+	s_pWaitLoop = NULL;
+	if (s_nBlockFF) {
+		for (int n = 0; n < s_nWaitLoops; n++) {
+			if (s_waitLoops[n].pc == startpc) {
+				s_pWaitLoop = &s_waitLoops[n];
+				break;
+			}
+		}
+
+		if (!s_pWaitLoop && s_nWaitLoops < (int)ArraySize(s_waitLoops)) {
+			s_pWaitLoop = &s_waitLoops[s_nWaitLoops++];
+			s_pWaitLoop->pc = startpc;
+		}
+	}
+
 	// rec info //
 	{
 		EEINST* pcur;
@@ -1653,9 +2238,14 @@ StartRecomp:
 		_recClearInst(pcur);
 		pcur->info = 0;
 
+		// The read/write lists drive the spill choice, the const reg immediates, the early
+		// flushes of unused regs and the guessed-page loads/stores.  Until those have been
+		// validated they are only filled with EERegLiveness on; left empty, every one of them
+		// takes its old path.
 		for(i = s_nEndBlock; i > startpc; i -= 4 ) {
 			cpuRegs.code = *(int *)PSM(i-4);
 			pcur[-1] = pcur[0];
+			if( EmuConfig.Cpu.Recompiler.EERegLiveness ) rpropBSC(pcur);
 			pcur--;
 		}
 	}
@@ -1728,76 +2318,51 @@ StartRecomp:
 	// note: blocks are guaranteed to reside within the confines of a single page.
 
 	const int PageType = mmap_GetRamPageInfo( inpage_ptr );
-	//const u32 pgsz = std::min(0x1000 - inpage_offs, inpage_sz);
-	const u32 pgsz = inpage_sz;
-
-    switch (PageType)
-    {
-        case -1:
-            break;
+	s32* checkFail[0x400];
+	int checkFails = 0;
+	s32* pageBusy = NULL;
 
-        case 0:
-			mmap_MarkCountedRamPage( inpage_ptr );
-			manual_page[inpage_ptr >> 12] = 0;
-			break;
+	if (PageType == 0)
+	{
+		// No check on entry, a checking entry is added after the block's code for the case
+		// the page loses its write protection (see recSelfCheckPage).
 
-        default:
-			xMOV( ecx, inpage_ptr );
-			xMOV( edx, pgsz / 4 );
-			//xMOV( eax, startpc );		// uncomment this to access startpc (as eax) in dyna_block_discard
+		mmap_MarkCountedRamPage( inpage_ptr );
+		manual_page[inpage_ptr >> 12] = 0;
+	}
+	else if (PageType > 0)
+	{
+		// The page is under manual protection: the block compares its code on every entry.
 
-			u32 lpc = inpage_ptr;
-			u32 stg = pgsz;
+		for (u32 lpc = inpage_ptr; lpc < inpage_ptr + inpage_sz; lpc += 4)
+		{
+			xCMP( ptr32[PSM(lpc)], *(u32*)PSM(lpc) );
+			checkFail[checkFails++] = xJcc32( Jcc_NotEqual );
+		}
 
-			while(stg>0)
-			{
-				xCMP( ptr32[PSM(lpc)], *(u32*)PSM(lpc) );
-				xJNE( dyna_block_discard );
+		xADD( ptr32[(u32*)&mmap_smcStats.checkedWords], sz );
+		xADC( ptr32[(u32*)&mmap_smcStats.checkedWords + 1], 0 );
 
-				stg -= 4;
-				lpc += 4;
-			}
+		// Tweakpoint!  3 is a 'magic' number representing the number of times a page is
+		// re-protected before the recompiler gives up and leaves it under manual protection.
 
-			// Tweakpoint!  3 is a 'magic' number representing the number of times a counted block
-			// is re-protected before the recompiler gives up and sets it up as an uncounted (permanent)
-			// manual block.  Higher thresholds result in more recompilations for blocks that share code
-			// and data on the same page.  Side effects of a lower threshold: over extended gameplay
-			// with several map changes, a game's overall performance could degrade.
+		if (startpc != 0x81fc0 && manual_counter[inpage_ptr >> 12] <= 3)
+		{
+			// Counted blocks add a weighted (by block size) value into manual_page each time
+			// they're run.  If the page gets run a lot, it is re-protected in the hope that
+			// whatever forced it to be manually-checked before was a 1-time deal.
 
-			// (ideally, perhaps, manual_counter should be reset to 0 every few minutes?)
+			xADD( ptr16[&manual_page[inpage_ptr >> 12]], sz );
+			pageBusy = xJcc32( Jcc_Carry );
 
-			if (startpc != 0x81fc0 && manual_counter[inpage_ptr >> 12] <= 3)
-			{
-				// Counted blocks add a weighted (by block size) value into manual_page each time they're
-				// run.  If the block gets run a lot, it resets and re-protects itself in the hope
-				// that whatever forced it to be manually-checked before was a 1-time deal.
-
-				// Counted blocks have a secondary threshold check in manual_counter, which forces a block
-				// to 'uncounted' mode if it's recompiled several times.  This protects against excessive
-				// recompilation of blocks that reside on the same codepage as data.
-
-				// fixme? Currently this algo is kinda dumb and results in the forced recompilation of a
-				// lot of blocks before it decides to mark a 'busy' page as uncounted.  There might be
-				// be a more clever approach that could streamline this process, by doing a first-pass
-				// test using the vtlb memory protection (without recompilation!) to reprotect a counted
-				// block.  But unless a new algo is relatively simple in implementation, it's probably
-				// not worth the effort (tests show that we have lots of recompiler memory to spare, and
-				// that the current amount of recompilation is fairly cheap).
-
-				xADD(ptr16[&manual_page[inpage_ptr >> 12]], sz);
-				xJC( dyna_page_reset );
-
-				// note: clearcnt is measured per-page, not per-block!
-				ConsoleColorScope cs( Color_Gray );
-				eeRecPerfLog.Write( "Manual block @ %08X : size =%3d  page/offs = 0x%05X/0x%03X  inpgsz = %d  clearcnt = %d",
-					startpc, sz, inpage_ptr>>12, inpage_ptr&0xfff, inpage_sz, manual_counter[inpage_ptr >> 12] );
-			}
-			else
-			{
-				eeRecPerfLog.Write( "Uncounted Manual block @ 0x%08X : size =%3d page/offs = 0x%05X/0x%03X  inpgsz = %d",
-					startpc, sz, inpage_ptr>>12, inpage_ptr&0xfff, pgsz, inpage_sz );
-			}
-            break;
+			eeRecPerfLog.Write( "Manual block @ %08X : size =%3d  page/offs = 0x%05X/0x%03X  inpgsz = %d  clearcnt = %d",
+				startpc, sz, inpage_ptr>>12, inpage_ptr&0xfff, inpage_sz, manual_counter[inpage_ptr >> 12] );
+		}
+		else
+		{
+			eeRecPerfLog.Write( "Uncounted Manual block @ 0x%08X : size =%3d page/offs = 0x%05X/0x%03X  inpgsz = %d",
+				startpc, sz, inpage_ptr>>12, inpage_ptr&0xfff, inpage_sz );
+		}
 	}
 
 	// Skip Recompilation if sceMpegIsEnd Pattern detected
@@ -1809,6 +2374,7 @@ StartRecomp:
 		while (!branch && pc < s_nEndBlock) {
 			recompileNextInstruction(0);		// For the love of recursion, batman!
 		}
+		pxAssert( !mVUmacroCached() );
 	}
 
 #ifdef PCSX2_DEBUG
@@ -1818,6 +2384,9 @@ StartRecomp:
 	pxAssert( (pc-startpc)>>2 <= 0xffff );
 	s_pCurBlockEx->size = (pc-startpc)>>2;
 
+	if (PageType >= 0 && s_pCurBlockEx->size > 0)
+		mmap_MarkCodeRange( HWADDR(startpc), s_pCurBlockEx->size * 4 );
+
 	if (HWADDR(pc) <= Ps2MemSize::MainRam) {
 		BASEBLOCKEX *oldBlock;
 		int i;
@@ -1892,6 +2461,41 @@ StartRecomp:
 		}
 	}
 
+	// Out of line parts of the code checks, the block's code has ended with a jump.
+
+	if (checkFails > 0)
+	{
+		for (int f = 0; f < checkFails; f++)
+			*checkFail[f] = (s32)(xGetPtr() - (u8*)(checkFail[f] + 1));
+
+		xMOV( ecx, inpage_ptr );
+		xMOV( edx, sz );
+		xCALL( dyna_block_discard );
+		xJMP( ExitRecompiledCode );
+	}
+
+	if (pageBusy)
+	{
+		// all blocks checking their code inline are cleared, this one included
+		*pageBusy = (s32)(xGetPtr() - (u8*)(pageBusy + 1));
+
+		xMOV( ecx, inpage_ptr );
+		xCALL( dyna_page_reprotect );
+		xJMP( ExitRecompiledCode );
+	}
+
+	if (PageType == 0 && s_pCurBlockEx->size > 0)
+	{
+		s_pCurBlockEx->checkfn = (uptr)xGetPtr();
+
+		xMOV( ecx, inpage_ptr );
+		xMOV( edx, s_pCurBlockEx->size );
+		xCALL( dyna_block_check );
+		xTEST( al, al );
+		xJNZ( ExitRecompiledCode );
+		xJMP( (void*)recPtr );
+	}
+
 	pxAssert( xGetPtr() < recMem->GetPtrEnd() );
 	pxAssert( recConstBufPtr < recConstBuf + RECCONSTBUF_SIZE );
 	pxAssert( x86FpuState == 0 );
@@ -1905,6 +2509,17 @@ StartRecomp:
 
 	s_pCurBlock = NULL;
 	s_pCurBlockEx = NULL;
+
+	s_recompileTicks += GetCPUTicks() - recompileStart;
+	s_recompileCount++;
+
+	if( g_recRegStats.spills != regStart.spills || g_recRegStats.flushes != regStart.flushes )
+		eeRecPerfLog.Write( "Block @ %08X : %u reg spills, %u reg flushes at calls", startpc,
+			g_recRegStats.spills - regStart.spills, g_recRegStats.flushes - regStart.flushes );
+
+	if( g_recCop2Stats.flushes != cop2Start.flushes || g_recCop2Stats.macFlags != cop2Start.macFlags )
+		eeRecPerfLog.Write( "Block @ %08X : %u VU0 macro flushes and %u Mac flag updates skipped", startpc,
+			g_recCop2Stats.flushes - cop2Start.flushes, g_recCop2Stats.macFlags - cop2Start.macFlags );
 }
 
 // The only *safe* way to throw exceptions from the context of recompiled code.
@@ -69,6 +69,7 @@ void recJAL( void )
 	}
 
 	recompileNextInstruction(1);
+	SetBranchReturn(pc);
 	SetBranchImm(newpc);
 }
 
@@ -140,6 +141,7 @@ void recJALR( void )
 		MOV32RtoM((int)&cpuRegs.pc, EAX);
 	}
 
+	if ( _Rd_ ) SetBranchReturn(newpc);
 	SetBranchReg(0xffffffff);
 }
 
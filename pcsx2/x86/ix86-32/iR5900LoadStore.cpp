@@ -139,7 +139,10 @@ void recLoad64( u32 bits, bool sign )
 		_deleteEEreg(_Rt_, 0);
 		iFlushCall(FLUSH_FULLVTLB);
 
-		vtlb_DynGenRead64(bits);
+		if (_eeIsRegEntryValue(_Rs_))
+			vtlb_DynGenRead64_Spec(bits, cpuRegs.GPR.r[_Rs_].UL[0] + _Imm_);
+		else
+			vtlb_DynGenRead64(bits);
 	}
 }
 
@@ -171,7 +174,11 @@ void recLoad32( u32 bits, bool sign )
 		_deleteEEreg(_Rt_, 0);
 
 		iFlushCall(FLUSH_FULLVTLB);
-		vtlb_DynGenRead32(bits, sign);
+
+		if (_eeIsRegEntryValue(_Rs_))
+			vtlb_DynGenRead32_Spec(bits, sign, cpuRegs.GPR.r[_Rs_].UL[0] + _Imm_);
+		else
+			vtlb_DynGenRead32(bits, sign);
 	}
 
 	if (_Rt_)
@@ -231,7 +238,10 @@ void recStore(u32 bits)
 
                 iFlushCall(FLUSH_FULLVTLB);
 
-				vtlb_DynGenWrite(bits);
+                if (_eeIsRegEntryValue(_Rs_))
+                        vtlb_DynGenWrite_Spec(bits, cpuRegs.GPR.r[_Rs_].UL[0] + _Imm_);
+                else
+                        vtlb_DynGenWrite(bits);
         }
 }
 
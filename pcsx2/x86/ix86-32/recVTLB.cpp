@@ -18,6 +18,7 @@
 
 #include "Common.h"
 #include "vtlb.h"
+#include "Cache.h"
 
 #include "iCore.h"
 #include "iR5900.h"
@@ -336,11 +337,99 @@ void vtlb_dynarec_init()
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
-//                            Dynarec Load Implementations
-void vtlb_DynGenRead64(u32 bits)
+//                              EE Data Cache (CHECK_CACHE)
+//
+// The cache emulation lives in the vtlb_mem* handlers.  When it is enabled, accesses
+// to pages that a TLB entry maps as cached are sent there, while everything else keeps
+// the regular paths below.  The page test is inline:
+//
+//	mov eax,ecx;
+//	shr eax,VTLB_PAGE_BITS;
+//	cmp byte [eax+pCachePages],0;
+//	jz _regular;
+//	call vtlb_memRead/Write;
+//	jmp cont;
+//	_regular:
+//	........
+//
+// The handlers take the same registers as the indirect dispatchers: ecx is the address,
+// edx the data (or a pointer to it for 64/128 bits), and 8/16/32 bit reads return eax.
+
+static void DynGen_CacheTest()
 {
-	jASSUME( bits == 64 || bits == 128 );
+	xMOV( eax, ecx );
+	xSHR( eax, VTLB_PAGE_BITS );
+	xCMP( ptr8[eax + pCachePages], 0 );
+}
+
+// mode - 0 for read, 1 for write!
+static void DynGen_CacheCall( int mode, u32 bits, bool sign = false )
+{
+	if( !mode )
+	{
+		switch( bits )
+		{
+			case 8:		xCALL( vtlb_memRead<mem8_t> );	break;
+			case 16:	xCALL( vtlb_memRead<mem16_t> );	break;
+			case 32:	xCALL( vtlb_memRead<mem32_t> );	break;
+			case 64:	xCALL( vtlb_memRead64 );			break;
+			case 128:	xCALL( vtlb_memRead128 );		break;
+			jNO_DEFAULT
+		}
+
+		if( bits == 8 )
+		{
+			if( sign )
+				xMOVSX( eax, al );
+			else
+				xMOVZX( eax, al );
+		}
+		else if( bits == 16 )
+		{
+			if( sign )
+				xMOVSX( eax, ax );
+			else
+				xMOVZX( eax, ax );
+		}
+	}
+	else
+	{
+		switch( bits )
+		{
+			case 8:		xCALL( vtlb_memWrite<mem8_t> );	break;
+			case 16:	xCALL( vtlb_memWrite<mem16_t> );	break;
+			case 32:	xCALL( vtlb_memWrite<mem32_t> );	break;
+			case 64:	xCALL( vtlb_memWrite64 );		break;
+			case 128:	xCALL( vtlb_memWrite128 );		break;
+			jNO_DEFAULT
+		}
+	}
+}
+
+// Const address version, emitted in front of the direct accesses of the _Const paths.
+// The TLB may mark the page cached after the block is compiled, so the test stays at
+// runtime.  Returns the jump over the direct access (to be set with x86SetJ32), or NULL
+// if the cache is disabled.
+static s32* DynGen_CacheConst( int mode, u32 bits, bool sign, u32 addr_const )
+{
+	if( !CHECK_CACHE ) return NULL;
+
+	iFlushCall(FLUSH_FULLVTLB);
+	xCMP( ptr8[&pCachePages[addr_const >> VTLB_PAGE_BITS]], 0 );
+	xForwardJZ32 uncached;
 
+	xMOV( ecx, addr_const );
+	DynGen_CacheCall( mode, bits, sign );
+	s32* done = xJcc32();
+
+	uncached.SetTarget();
+	return done;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//                            Dynarec Load Implementations
+static void DynGen_Read64(u32 bits)
+{
 	uptr* writeback = DynGen_PrepRegs();
 
 	DynGen_IndirectDispatch( 0, bits );
@@ -349,14 +438,28 @@ void vtlb_DynGenRead64(u32 bits)
 	*writeback = (uptr)xGetPtr();		// return target for indirect's call/ret
 }
 
-// ------------------------------------------------------------------------
-// Recompiled input registers:
-//   ecx - source address to read from
-//   Returns read value in eax.
-void vtlb_DynGenRead32(u32 bits, bool sign)
+void vtlb_DynGenRead64(u32 bits)
 {
-	jASSUME( bits <= 32 );
+	jASSUME( bits == 64 || bits == 128 );
 
+	if( CHECK_CACHE )
+	{
+		DynGen_CacheTest();
+		xForwardJZ32 uncached;
+		DynGen_CacheCall( 0, bits );
+		xForwardJump32 done;
+
+		uncached.SetTarget();
+		DynGen_Read64( bits );
+		done.SetTarget();
+	}
+	else
+		DynGen_Read64( bits );
+}
+
+// ------------------------------------------------------------------------
+static void DynGen_Read32(u32 bits, bool sign)
+{
 	uptr* writeback = DynGen_PrepRegs();
 
 	DynGen_IndirectDispatch( 0, bits, sign && bits < 32 );
@@ -365,6 +468,28 @@ void vtlb_DynGenRead32(u32 bits, bool sign)
 	*writeback = (uptr)xGetPtr();
 }
 
+// Recompiled input registers:
+//   ecx - source address to read from
+//   Returns read value in eax.
+void vtlb_DynGenRead32(u32 bits, bool sign)
+{
+	jASSUME( bits <= 32 );
+
+	if( CHECK_CACHE )
+	{
+		DynGen_CacheTest();
+		xForwardJZ32 uncached;
+		DynGen_CacheCall( 0, bits, sign );
+		xForwardJump32 done;
+
+		uncached.SetTarget();
+		DynGen_Read32( bits, sign );
+		done.SetTarget();
+	}
+	else
+		DynGen_Read32( bits, sign );
+}
+
 // ------------------------------------------------------------------------
 // TLB lookup is performed in const, with the assumption that the COP0/TLB will clear the
 // recompiler if the TLB is changed.
@@ -374,6 +499,8 @@ void vtlb_DynGenRead64_Const( u32 bits, u32 addr_const )
 	s32 ppf = addr_const + vmv_ptr;
 	if( ppf >= 0 )
 	{
+		s32* cached = DynGen_CacheConst( 0, bits, false, addr_const );
+
 		switch( bits )
 		{
 			case 64:
@@ -386,6 +513,8 @@ void vtlb_DynGenRead64_Const( u32 bits, u32 addr_const )
 
 			jNO_DEFAULT
 		}
+
+		if( cached ) x86SetJ32( (u32*)cached );
 	}
 	else
 	{
@@ -420,6 +549,8 @@ void vtlb_DynGenRead32_Const( u32 bits, bool sign, u32 addr_const )
 	s32 ppf = addr_const + vmv_ptr;
 	if( ppf >= 0 )
 	{
+		s32* cached = DynGen_CacheConst( 0, bits, sign, addr_const );
+
 		switch( bits )
 		{
 			case 8:
@@ -440,6 +571,8 @@ void vtlb_DynGenRead32_Const( u32 bits, bool sign, u32 addr_const )
 				xMOV( eax, ptr[(void*)ppf] );
 			break;
 		}
+
+		if( cached ) x86SetJ32( (u32*)cached );
 	}
 	else
 	{
@@ -486,10 +619,141 @@ void vtlb_DynGenRead32_Const( u32 bits, bool sign, u32 addr_const )
 	}
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////
+//                        Speculative (guessed page) Implementations
+//
+// For addresses that aren't constant the recompiler passes the address the access would
+// have had on the block's first run (the block is compiled right before that run).  If
+// that page is directly mapped RAM or scratchpad, the page's vmap entry is folded into
+// the code behind a guard:
+//
+//	mov eax,ecx;
+//	sub eax,page;
+//	cmp eax,VTLB_PAGE_SIZE;
+//	jae _fullaccess;
+//	add ecx,vmv;
+//	<direct access>
+//	jmp cont;
+//	_fullaccess:
+//	<regular vtlb lookup>
+//	cont:
+//
+// Like the _Const versions, this relies on the TLB clearing the recompiler when the
+// mappings change.
+
+vtlb_SpecStats vtlb_specStats;
+
+// Returns the vmap value of the guessed page, or 0 if the page isn't directly mapped RAM
+// or scratchpad (in which case speculating isn't worth it).
+static u32 DynGen_SpecVmv( u32 addr_guess )
+{
+	// the guarded direct access would bypass the cache emulation
+	if( CHECK_CACHE ) return 0;
+
+	u32 vmv = vtlbdata.vmap[addr_guess>>VTLB_PAGE_BITS];
+	s32 ppf = (addr_guess & ~VTLB_PAGE_MASK) + vmv;
+	if( ppf < 0 ) return 0;
+
+	const u8* host = (u8*)ppf;
+	if( host >= eeMem->Main && host < eeMem->Main + Ps2MemSize::MainRam ) return vmv;
+	if( host >= eeMem->Scratch && host < eeMem->Scratch + Ps2MemSize::Scratch ) return vmv;
+	return 0;
+}
+
+// Compares ecx against the guessed page; the caller branches to the full lookup on JAE.
+static void DynGen_SpecGuard( u32 addr_guess )
+{
+	xMOV( eax, ecx );
+	xSUB( eax, addr_guess & ~VTLB_PAGE_MASK );
+	xCMP( eax, VTLB_PAGE_SIZE );
+
+	vtlb_specStats.sites++;
+}
+
+// Translates ecx to the host pointer of the guessed page.
+static void DynGen_SpecHit( u32 vmv )
+{
+#ifdef PCSX2_DEVBUILD
+	xADD( ptr32[&vtlb_specStats.hits], 1 );
+#endif
+	xADD( ecx, vmv );
+}
+
+void vtlb_DynGenRead64_Spec( u32 bits, u32 addr_guess )
+{
+	u32 vmv = DynGen_SpecVmv( addr_guess );
+	if( !vmv )
+	{
+		vtlb_DynGenRead64( bits );
+		return;
+	}
+
+	DynGen_SpecGuard( addr_guess );
+	xForwardJAE32 miss;
+
+	DynGen_SpecHit( vmv );
+	DynGen_DirectRead( bits, false );
+	xForwardJump32 done;
+
+	miss.SetTarget();
+	xADD( ptr32[&vtlb_specStats.misses], 1 );
+	vtlb_DynGenRead64( bits );
+	done.SetTarget();
+}
+
+// ------------------------------------------------------------------------
+// Recompiled input registers:
+//   ecx - source address to read from
+//   Returns read value in eax.
+void vtlb_DynGenRead32_Spec( u32 bits, bool sign, u32 addr_guess )
+{
+	u32 vmv = DynGen_SpecVmv( addr_guess );
+	if( !vmv )
+	{
+		vtlb_DynGenRead32( bits, sign );
+		return;
+	}
+
+	DynGen_SpecGuard( addr_guess );
+	xForwardJAE32 miss;
+
+	DynGen_SpecHit( vmv );
+	DynGen_DirectRead( bits, sign );
+	xForwardJump32 done;
+
+	miss.SetTarget();
+	xADD( ptr32[&vtlb_specStats.misses], 1 );
+	vtlb_DynGenRead32( bits, sign );
+	done.SetTarget();
+}
+
+// ------------------------------------------------------------------------
+void vtlb_DynGenWrite_Spec( u32 bits, u32 addr_guess )
+{
+	u32 vmv = DynGen_SpecVmv( addr_guess );
+	if( !vmv )
+	{
+		vtlb_DynGenWrite( bits );
+		return;
+	}
+
+	DynGen_SpecGuard( addr_guess );
+	xForwardJAE32 miss;
+
+	DynGen_SpecHit( vmv );
+	DynGen_DirectWrite( bits );
+	xForwardJump32 done;
+
+	miss.SetTarget();
+	xADD( ptr32[&vtlb_specStats.misses], 1 );
+	vtlb_DynGenWrite( bits );
+	done.SetTarget();
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //                            Dynarec Store Implementations
 
-void vtlb_DynGenWrite(u32 sz)
+static void DynGen_Write(u32 sz)
 {
 	uptr* writeback = DynGen_PrepRegs();
 
@@ -499,6 +763,23 @@ void vtlb_DynGenWrite(u32 sz)
 	*writeback = (uptr)xGetPtr();
 }
 
+void vtlb_DynGenWrite(u32 sz)
+{
+	if( CHECK_CACHE )
+	{
+		DynGen_CacheTest();
+		xForwardJZ32 uncached;
+		DynGen_CacheCall( 1, sz );
+		xForwardJump32 done;
+
+		uncached.SetTarget();
+		DynGen_Write( sz );
+		done.SetTarget();
+	}
+	else
+		DynGen_Write( sz );
+}
+
 
 // ------------------------------------------------------------------------
 // Generates code for a store instruction, where the address is a known constant.
@@ -510,6 +791,8 @@ void vtlb_DynGenWrite_Const( u32 bits, u32 addr_const )
 	s32 ppf = addr_const + vmv_ptr;
 	if( ppf >= 0 )
 	{
+		s32* cached = DynGen_CacheConst( 1, bits, false, addr_const );
+
 		switch(bits)
 		{
 			//8 , 16, 32 : data on EDX
@@ -534,6 +817,7 @@ void vtlb_DynGenWrite_Const( u32 bits, u32 addr_const )
 			break;
 		}
 
+		if( cached ) x86SetJ32( (u32*)cached );
 	}
 	else
 	{
@@ -29,14 +29,54 @@ using namespace R5900::Dynarec;
 #define printCOP2 0&&
 //#define printCOP2 DevCon.Status
 
+void recCOP2_SPEC1();
+
+RecCop2Stats g_recCop2Stats;
+
+static bool macroPeek		= false; // Set while getNextMacroMode() asks the next op for its mode
+static int  macroPeekMode	= -1;
+static int  macroNextMode	= -1;	 // Mode of the op following the one being recompiled
+static int  macroCached		=  0;	 // VF regs (0x01) and Status Flag in gprF0 (0x10) left by the previous op
+
+// Returns the mode of the next instruction if it is a macro op of this block, else -1.
+// Nothing that touches the VU0 regs runs between the two then, so they can stay cached.
+static int getNextMacroMode() {
+	if (g_recompilingDelaySlot || pc >= s_nEndBlock || recBlockCodeFull()) return -1;
+
+	const u32 code = *(u32*)PSM(pc);
+	if ((code >> 26) != 0x12 || !(code & 0x02000000)) return -1; // COP2 with the CO bit set
+
+	const u32 curCode = cpuRegs.code;
+	macroPeek	  = true;
+	macroPeekMode = -1;
+	cpuRegs.code  = code;
+	recCOP2_SPEC1();
+	cpuRegs.code  = curCode;
+	macroPeek	  = false;
+	return macroPeekMode;
+}
+
+bool mVUmacroCached() {
+	return macroCached != 0;
+}
+
+// Called when a new block is started, nothing is cached from the previous one.
+void mVUmacroReset() {
+	macroCached	  = 0;
+	macroNextMode = -1;
+}
+
 void setupMacroOp(int mode, const char* opName) {
 	printCOP2(opName);
+	macroNextMode = getNextMacroMode();
 	microVU0.cop2 = 1;
 	microVU0.prog.IRinfo.curPC = 0;
 	microVU0.code = cpuRegs.code;
 	memset(&microVU0.prog.IRinfo.info[0], 0, sizeof(microVU0.prog.IRinfo.info[0]));
-	iFlushCall(FLUSH_EVERYTHING);
-	microVU0.regAlloc->reset();
+	if (!macroCached) {
+		iFlushCall(FLUSH_EVERYTHING);
+		microVU0.regAlloc->reset();
+	}
 	if (mode & 0x01) { // Q-Reg will be Read
 		xMOVSSZX(xmmPQ, ptr32[&vu0Regs.VI[REG_Q].UL]);
 	}
@@ -51,8 +91,16 @@ void setupMacroOp(int mode, const char* opName) {
 		microVU0.prog.IRinfo.info[0].sFlag.lastWrite	= 0;
 		microVU0.prog.IRinfo.info[0].mFlag.doFlag		= 1;
 		microVU0.prog.IRinfo.info[0].mFlag.write		= 0xff;
+
+		// The next op overwrites the Mac Flag without reading it
+		if (macroNextMode >= 0 && (macroNextMode & 0x10)) {
+			microVU0.prog.IRinfo.info[0].mFlag.doFlag	= 0;
+			g_recCop2Stats.macFlags++;
+		}
 		
-		xMOV(gprF0, ptr32[&vu0Regs.VI[REG_STATUS_FLAG].UL]);
+		if (!(macroCached & 0x10)) {
+			xMOV(gprF0, ptr32[&vu0Regs.VI[REG_STATUS_FLAG].UL]);
+		}
 	}
 }
 
@@ -61,14 +109,24 @@ void endMacroOp(int mode) {
 		xMOVSS(ptr32[&vu0Regs.VI[REG_Q].UL], xmmPQ);
 	}
 	if (mode & 0x10) { // Status/Mac Flags were Updated
-		xMOV(ptr32[&vu0Regs.VI[REG_STATUS_FLAG].UL], gprF0);
+		if (macroNextMode < 0 || !(macroNextMode & 0x10)) {
+			xMOV(ptr32[&vu0Regs.VI[REG_STATUS_FLAG].UL], gprF0);
+		}
+	}
+	if (macroNextMode >= 0) { // Next op continues with the cached regs
+		macroCached = 0x01 | (mode & macroNextMode & 0x10);
+		g_recCop2Stats.flushes++;
+	}
+	else {
+		microVU0.regAlloc->flushAll();
+		macroCached = 0;
 	}
-	microVU0.regAlloc->flushAll();
 	microVU0.cop2 = 0;
 }
 
 #define REC_COP2_mVU0(f, opName, mode)						\
 	void recV##f() {										\
+		if (macroPeek) { macroPeekMode = mode; return; }	\
 		setupMacroOp(mode, opName);							\
 		if (mode & 4) {										\
 			mVU_##f(microVU0, 0);							\
@@ -82,6 +140,7 @@ void endMacroOp(int mode) {
 
 #define INTERPRETATE_COP2_FUNC(f)							\
 	void recV##f() {										\
+		if (macroPeek) return;								\
 		recCall(V##f);										\
 		_freeX86regs();										\
 	}
@@ -374,6 +433,7 @@ void recCOP2_BC2();
 void recCOP2_SPEC1();
 void recCOP2_SPEC2();
 void rec_C2UNK() {
+	if (macroPeek) return;
 	Console.Error("Cop2 bad opcode: %x", cpuRegs.code);
 }
 
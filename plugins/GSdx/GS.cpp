@@ -26,6 +26,7 @@
 #include "GSRendererNull.h"
 #include "GSDeviceSDL.h"
 #include "GSDeviceNull.h"
+#include "GSDeviceSW.h"
 
 #ifdef _WINDOWS
 
@@ -647,6 +648,209 @@ EXPORT_C GSsetFrameLimit(int limit)
 	}
 }
 
+// Regression harness of the software renderer, replays a gs dump without a window and hashes the
+// local memory and the displayed circuits after every vsync.
+//
+//   dump: the gs file to replay
+//   golden: one "frame vm out" line per vsync, recorded from this run if the file does not exist yet
+//   frames: number of vsyncs, the dump is looped until then (0 = a single pass)
+//
+// Returns the number of frames that do not match the golden hashes, or -1 on error.
+
+EXPORT_C_(int) GSReplayHash(const char* dump, const char* golden, int frames)
+{
+	FILE* fp = fopen(dump, "rb");
+
+	if(fp == NULL)
+	{
+		fprintf(stderr, "GSdx: cannot open %s\n", dump);
+
+		return -1;
+	}
+
+	if(!GSUtil::CheckSSE())
+	{
+		fclose(fp);
+
+		return -1;
+	}
+
+	vector<uint64> hashes;
+
+	bool record = true;
+
+	if(FILE* gp = fopen(golden, "r"))
+	{
+		int frame;
+		unsigned long long vm, out;
+
+		while(fscanf(gp, "%d %llx %llx", &frame, &vm, &out) == 3)
+		{
+			hashes.push_back(vm);
+			hashes.push_back(out);
+		}
+
+		fclose(gp);
+
+		record = false;
+	}
+
+	delete s_gs;
+
+	GSRendererSW* gs = new GSRendererSW(theApp.GetConfig("extrathreads", 0));
+
+	s_gs = gs;
+	s_renderer = -1;
+
+	uint8 regs[0x2000];
+
+	GSsetBaseMem(regs);
+
+	s_gs->SetIrqCallback(s_irq);
+	s_gs->CreateDevice(new GSDeviceSW());
+
+	uint32 crc;
+	fread(&crc, 4, 1, fp);
+	GSsetGameCRC(crc, 0);
+
+	GSFreezeData fd;
+	fread(&fd.size, 4, 1, fp);
+	fd.data = new uint8[fd.size];
+	fread(fd.data, fd.size, 1, fp);
+	GSfreeze(FREEZE_LOAD, &fd);
+	delete [] fd.data;
+
+	fread(regs, 0x2000, 1, fp);
+
+	long start = ftell(fp);
+
+	vector<uint8> buff;
+
+	int frame = 0;
+	int mismatches = 0;
+
+	uint32 time = GSUtil::GetMilliseconds();
+
+	bool exit = false;
+
+	while(!exit)
+	{
+		uint32 index;
+		uint32 size;
+		uint32 addr;
+
+		switch(fgetc(fp))
+		{
+		case EOF:
+			fseek(fp, start, 0);
+			exit = frames == 0 || frame == 0;
+			break;
+
+		case 0:
+			index = fgetc(fp);
+			fread(&size, 4, 1, fp);
+
+			switch(index)
+			{
+			case 0:
+				if(buff.size() < 0x4000) buff.resize(0x4000);
+				addr = 0x4000 - size;
+				fread(&buff[addr], size, 1, fp);
+				GSgifTransfer1(&buff[0], addr);
+				break;
+
+			case 1:
+				if(buff.size() < size) buff.resize(size);
+				fread(&buff[0], size, 1, fp);
+				GSgifTransfer2(&buff[0], size / 16);
+				break;
+
+			case 2:
+				if(buff.size() < size) buff.resize(size);
+				fread(&buff[0], size, 1, fp);
+				GSgifTransfer3(&buff[0], size / 16);
+				break;
+
+			case 3:
+				if(buff.size() < size) buff.resize(size);
+				fread(&buff[0], size, 1, fp);
+				GSgifTransfer(&buff[0], size / 16);
+				break;
+			}
+
+			break;
+
+		case 1:
+			fgetc(fp); // field, only used by merging the circuits
+
+			{
+				uint64 vm, out;
+
+				gs->VSyncHash(vm, out);
+
+				if(record)
+				{
+					hashes.push_back(vm);
+					hashes.push_back(out);
+				}
+				else if(frame * 2 + 1 >= (int)hashes.size() || hashes[frame * 2] != vm || hashes[frame * 2 + 1] != out)
+				{
+					if(mismatches++ == 0)
+					{
+						printf("%s: frame %d differs (vm %016llx out %016llx)\n", dump, frame, (unsigned long long)vm, (unsigned long long)out);
+					}
+				}
+			}
+
+			exit = ++frame == frames;
+			break;
+
+		case 2:
+			fread(&size, 4, 1, fp);
+			if(buff.size() < size) buff.resize(size);
+			GSreadFIFO2(&buff[0], size / 16);
+			break;
+
+		case 3:
+			fread(regs, 0x2000, 1, fp);
+			break;
+		}
+	}
+
+	time = GSUtil::GetMilliseconds() - time;
+
+	fclose(fp);
+
+	delete s_gs;
+
+	s_gs = NULL;
+
+	if(record)
+	{
+		if(FILE* gp = fopen(golden, "w"))
+		{
+			for(int i = 0; i < frame; i++)
+			{
+				fprintf(gp, "%d %016llx %016llx\n", i, (unsigned long long)hashes[i * 2], (unsigned long long)hashes[i * 2 + 1]);
+			}
+
+			fclose(gp);
+		}
+		else
+		{
+			fprintf(stderr, "GSdx: cannot write %s\n", golden);
+
+			return -1;
+		}
+	}
+
+	printf("%s: %d frames, %d ms (%.2f ms/frame), %s\n",
+		dump, frame, (int)time, frame > 0 ? (float)time / frame : 0.0f,
+		record ? "recorded" : mismatches ? format("%d mismatches", mismatches).c_str() : "ok");
+
+	return mismatches;
+}
+
 #ifdef _WINDOWS
 
 #include <io.h>
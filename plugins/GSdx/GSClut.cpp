@@ -23,18 +23,36 @@
 #include "GSClut.h"
 #include "GSLocalMemory.h"
 
-#define CLUT_ALLOC_SIZE (2 * 4096)
+#define CLUT_ALLOC_SIZE (2 * 4096 + READ_CACHE * 4096)
 
 GSClut::GSClut(GSLocalMemory* mem)
 	: m_mem(mem)
+	, m_perfmon(NULL)
+	, m_load(0)
+	, m_clock(0)
 {
 	uint8* p = (uint8*)vmalloc(CLUT_ALLOC_SIZE, false);
 
 	m_clut = (uint16*)&p[0]; // 1k + 1k for buffer overruns (TODO: wrap CSM2 writes, too)
-	m_buff32 = (uint32*)&p[2048]; // 1k
-	m_buff64 = (uint64*)&p[4096]; // 2k
+	m_rbuff32 = (uint32*)&p[2048]; // 1k
+	m_rbuff64 = (uint64*)&p[4096]; // 2k
+	m_buff32 = m_rbuff32;
+	m_buff64 = m_rbuff64;
 	m_write.dirty = true;
+	m_write.entry = -1;
 	m_read.dirty = true;
+	m_read.entry = -1;
+
+	memset(m_slot, 0, sizeof(m_slot));
+	memset(m_deps, 0, sizeof(m_deps));
+	memset(m_wcache, 0, sizeof(m_wcache));
+	memset(m_rcache, 0, sizeof(m_rcache));
+
+	for(int i = 0; i < READ_CACHE; i++)
+	{
+		m_rcache[i].buff32 = (uint32*)&p[8192 + i * 4096]; // 1k
+		m_rcache[i].buff64 = (uint64*)&p[8192 + i * 4096 + 1024]; // 2k
+	}
 
 	for(int i = 0; i < 16; i++)
 	{
@@ -96,6 +114,197 @@ GSClut::~GSClut()
 void GSClut::Invalidate()
 {
 	m_write.dirty = true;
+
+	for(int i = 0; i < WRITE_CACHE; i++)
+	{
+		m_wcache[i].valid = false;
+	}
+
+	memset(m_deps, 0, sizeof(m_deps));
+}
+
+void GSClut::Invalidate(uint32 bp, uint32 bw, uint32 psm, const GSVector4i& r)
+{
+	uint32 pages[PAGES];
+
+	memset(pages, 0, sizeof(pages));
+
+	GetPages(pages, bp, bw, psm, r);
+
+	uint32 hit = 0;
+
+	for(int i = 0; i < PAGES; i++)
+	{
+		hit |= pages[i] & m_deps[i];
+	}
+
+	if(hit == 0)
+	{
+		return;
+	}
+
+	for(int i = 0; i < WRITE_CACHE; i++)
+	{
+		WriteEntry& e = m_wcache[i];
+
+		if(!e.valid) continue;
+
+		for(int j = 0; j < PAGES; j++)
+		{
+			if(pages[j] & e.pages[j])
+			{
+				e.valid = false;
+
+				if(m_write.entry == i)
+				{
+					m_write.dirty = true;
+				}
+
+				break;
+			}
+		}
+	}
+
+	UpdateDeps();
+}
+
+void GSClut::UpdateDeps()
+{
+	memset(m_deps, 0, sizeof(m_deps));
+
+	for(int i = 0; i < WRITE_CACHE; i++)
+	{
+		const WriteEntry& e = m_wcache[i];
+
+		if(!e.valid) continue;
+
+		for(int j = 0; j < PAGES; j++)
+		{
+			m_deps[j] |= e.pages[j];
+		}
+	}
+}
+
+void GSClut::GetKey(const GIFRegTEX0& TEX0, const GIFRegTEXCLUT& TEXCLUT, GIFRegTEX0& key, GIFRegTEXCLUT& keyclut)
+{
+	// only the fields that select the source and the destination of the load
+
+	key.u64 = 0;
+	key.PSM = TEX0.PSM;
+	key.CBP = TEX0.CBP;
+	key.CPSM = TEX0.CPSM & 0xa;
+	key.CSM = TEX0.CSM;
+	key.CSA = TEX0.CSA;
+
+	keyclut.u64 = 0;
+
+	if(TEX0.CSM)
+	{
+		keyclut.CBW = TEXCLUT.CBW;
+		keyclut.COU = TEXCLUT.COU;
+		keyclut.COV = TEXCLUT.COV;
+	}
+}
+
+void GSClut::GetSlots(const GIFRegTEX0& TEX0, int& first, int& count, bool& dual)
+{
+	// mirrors the destinations of the m_wc functions and Read/Read32, dual means the upper halfwords at +256 are also used
+
+	int pal = GSLocalMemory::m_psm[TEX0.PSM].pal;
+
+	first = 0;
+	count = 0;
+	dual = false;
+
+	if(pal == 0)
+	{
+		return;
+	}
+
+	switch(TEX0.CPSM & 0xa)
+	{
+	case PSM_PSMCT32:
+		dual = true;
+		if(TEX0.CSM) {first = TEX0.CSA; count = pal >> 4;}
+		else if(pal == 256) {first = 0; count = 16;}
+		else {first = TEX0.CSA & 15; count = 1;}
+		break;
+	case PSM_PSMCT16:
+	case PSM_PSMCT16S:
+		if(TEX0.CSM) {first = TEX0.CSA; count = pal >> 4;}
+		else if(pal == 256) {first = TEX0.CSA & 15; count = 16;}
+		else {first = TEX0.CSA; count = 1;}
+		break;
+	}
+}
+
+void GSClut::GetPages(uint32* RESTRICT pages, uint32 bp, uint32 bw, uint32 psm, const GSVector4i& r)
+{
+	// conservative, whole rows of pages between top and bottom plus one for a base pointer inside a page
+
+	if(r.left >= r.right || r.top >= r.bottom)
+	{
+		return;
+	}
+
+	const GSVector2i& pgs = GSLocalMemory::m_psm[psm].pgs;
+
+	int bwp = std::max<int>((bw * 64 + pgs.x - 1) / pgs.x, 1);
+
+	int start = (bp >> 5) + (r.top / pgs.y) * bwp;
+	int end = (bp >> 5) + ((r.bottom - 1) / pgs.y + 1) * bwp + 1;
+
+	end += std::max<int>((r.right - 1) / pgs.x + 1 - bwp, 0);
+
+	if(end - start >= MAX_PAGES)
+	{
+		memset(pages, 0xff, sizeof(uint32) * PAGES);
+
+		return;
+	}
+
+	for(int i = start; i < end; i++)
+	{
+		int j = i & (MAX_PAGES - 1);
+
+		pages[j >> 5] |= 1 << (j & 31);
+	}
+}
+
+bool GSClut::IsValid(const WriteEntry& e) const
+{
+	int first, count;
+	bool dual;
+
+	GetSlots(e.TEX0, first, count, dual);
+
+	for(int i = 0; i < count; i++)
+	{
+		if(m_slot[first + i] != e.id || dual && m_slot[first + 16 + i] != e.id)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool GSClut::IsValid(const ReadEntry& e) const
+{
+	int first, count;
+	bool dual;
+
+	GetSlots(e.TEX0, first, count, dual);
+
+	for(int i = 0; i < count; i++)
+	{
+		if(m_slot[first + i] != e.slot[i] || dual && m_slot[first + 16 + i] != e.slot[count + i])
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
 
 bool GSClut::WriteTest(const GIFRegTEX0& TEX0, const GIFRegTEXCLUT& TEXCLUT)
@@ -113,7 +322,46 @@ bool GSClut::WriteTest(const GIFRegTEX0& TEX0, const GIFRegTEXCLUT& TEXCLUT)
 	default: __assume(0);
 	}
 
-	return m_write.IsDirty(TEX0, TEXCLUT);
+	if(!m_write.IsDirty(TEX0, TEXCLUT))
+	{
+		return false;
+	}
+
+	// the same palette may still sit in its slots from an earlier load, switching between a few of them is common
+
+	GIFRegTEX0 key;
+	GIFRegTEXCLUT keyclut;
+
+	GetKey(TEX0, TEXCLUT, key, keyclut);
+
+	for(int i = 0; i < WRITE_CACHE; i++)
+	{
+		WriteEntry& e = m_wcache[i];
+
+		if(e.valid && e.TEX0.u64 == key.u64 && e.TEXCLUT.u64 == keyclut.u64)
+		{
+			if(!IsValid(e))
+			{
+				break;
+			}
+
+			e.used = ++m_clock;
+
+			m_write.TEX0 = TEX0;
+			m_write.TEXCLUT = TEXCLUT;
+			m_write.dirty = false;
+			m_write.entry = i;
+
+			if(m_perfmon != NULL)
+			{
+				m_perfmon->Put(GSPerfMon::ClutCached, 1);
+			}
+
+			return false;
+		}
+	}
+
+	return true;
 }
 
 void GSClut::Write(const GIFRegTEX0& TEX0, const GIFRegTEXCLUT& TEXCLUT)
@@ -124,6 +372,83 @@ void GSClut::Write(const GIFRegTEX0& TEX0, const GIFRegTEXCLUT& TEXCLUT)
 	m_read.dirty = true;
 
 	(this->*m_wc[TEX0.CSM][TEX0.CPSM][TEX0.PSM])(TEX0, TEXCLUT);
+
+	GIFRegTEX0 key;
+	GIFRegTEXCLUT keyclut;
+
+	GetKey(TEX0, TEXCLUT, key, keyclut);
+
+	int first, count;
+	bool dual;
+
+	GetSlots(key, first, count, dual);
+
+	uint32 id = ++m_load;
+
+	for(int i = 0; i < count; i++)
+	{
+		m_slot[first + i] = id;
+
+		if(dual)
+		{
+			m_slot[first + 16 + i] = id;
+		}
+	}
+
+	int index = 0;
+
+	for(int i = 0; i < WRITE_CACHE; i++)
+	{
+		const WriteEntry& e = m_wcache[i];
+
+		if(e.valid && e.TEX0.u64 == key.u64 && e.TEXCLUT.u64 == keyclut.u64)
+		{
+			index = i;
+
+			break;
+		}
+
+		if(!e.valid || m_wcache[index].valid && e.used < m_wcache[index].used)
+		{
+			index = i;
+		}
+	}
+
+	WriteEntry& e = m_wcache[index];
+
+	e.TEX0 = key;
+	e.TEXCLUT = keyclut;
+	e.id = id;
+	e.used = ++m_clock;
+	e.valid = true;
+
+	memset(e.pages, 0, sizeof(e.pages));
+
+	if(count > 0)
+	{
+		if(key.CSM == 0)
+		{
+			GetPages(e.pages, key.CBP, 1, key.CPSM, GSVector4i(0, 0, 16, 16));
+		}
+		else
+		{
+			int x = keyclut.COU << 4;
+
+			GetPages(e.pages, key.CBP, keyclut.CBW, key.CPSM, GSVector4i(x, keyclut.COV, x + (count << 4), keyclut.COV + 1));
+		}
+	}
+
+	for(int i = 0; i < PAGES; i++)
+	{
+		m_deps[i] |= e.pages[i];
+	}
+
+	m_write.entry = index;
+
+	if(m_perfmon != NULL)
+	{
+		m_perfmon->Put(GSPerfMon::ClutLoad, 1);
+	}
 }
 
 void GSClut::WriteCLUT32_I8_CSM1(const GIFRegTEX0& TEX0, const GIFRegTEXCLUT& TEXCLUT)
@@ -222,6 +547,10 @@ void GSClut::Read(const GIFRegTEX0& TEX0)
 	{
 		m_read.TEX0 = TEX0;
 		m_read.dirty = false;
+		m_read.entry = -1;
+
+		m_buff32 = m_rbuff32;
+		m_buff64 = m_rbuff64;
 
 		uint16* clut = m_clut;
 
@@ -271,7 +600,71 @@ void GSClut::Read32(const GIFRegTEX0& TEX0, const GIFRegTEXA& TEXA)
 		m_read.TEX0 = TEX0;
 		m_read.TEXA = TEXA;
 		m_read.dirty = false;
+
+		// the expanded palette only depends on the slots it reads and TEXA, keep a few around
+
+		GIFRegTEX0 key;
+
+		key.u64 = 0;
+		key.PSM = TEX0.PSM;
+		key.CPSM = TEX0.CPSM;
+		key.CSA = TEX0.CSA;
+
+		int index = 0;
+
+		for(int i = 0; i < READ_CACHE; i++)
+		{
+			ReadEntry& e = m_rcache[i];
+
+			if(e.valid && e.TEX0.u64 == key.u64 && e.TEXA.u64 == TEXA.u64 && IsValid(e))
+			{
+				e.used = ++m_clock;
+
+				m_buff32 = e.buff32;
+				m_buff64 = e.buff64;
+
+				m_read.adirty = e.adirty;
+				m_read.amin = e.amin;
+				m_read.amax = e.amax;
+				m_read.entry = i;
+
+				return;
+			}
+
+			if(!e.valid || m_rcache[index].valid && e.used < m_rcache[index].used)
+			{
+				index = i;
+			}
+		}
+
+		ReadEntry& e = m_rcache[index];
+
+		int first, count;
+		bool dual;
+
+		GetSlots(key, first, count, dual);
+
+		for(int i = 0; i < count; i++)
+		{
+			e.slot[i] = m_slot[first + i];
+
+			if(dual)
+			{
+				e.slot[count + i] = m_slot[first + 16 + i];
+			}
+		}
+
+		e.TEX0 = key;
+		e.TEXA = TEXA;
+		e.used = ++m_clock;
+		e.valid = true;
+		e.adirty = true;
+
+		m_buff32 = e.buff32;
+		m_buff64 = e.buff64;
+
 		m_read.adirty = true;
+		m_read.entry = index;
 
 		uint16* clut = m_clut;
 
@@ -379,6 +772,15 @@ void GSClut::GetAlphaMinMax32(int& amin, int& amax)
 			m_read.amin = v0.min_i16(v1).extract16<0>();
 			m_read.amax = v0.max_i16(v1).extract16<1>();
 		}
+
+		if(m_read.entry >= 0)
+		{
+			ReadEntry& e = m_rcache[m_read.entry];
+
+			e.adirty = false;
+			e.amin = m_read.amin;
+			e.amax = m_read.amax;
+		}
 	}
 
 	amin = m_read.amin;
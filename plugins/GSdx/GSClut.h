@@ -25,6 +25,7 @@
 #include "GSVector.h"
 #include "GSTables.h"
 #include "GSAlignedClass.h"
+#include "GSPerfMon.h"
 
 class GSLocalMemory;
 
@@ -32,16 +33,21 @@ __aligned(class, 32) GSClut : public GSAlignedClass<32>
 {
 	GSLocalMemory* m_mem;
 
+	GSPerfMon* m_perfmon;
+
 	uint32 m_CBP[2];
 	uint16* m_clut;
 	uint32* m_buff32;
 	uint64* m_buff64;
+	uint32* m_rbuff32;
+	uint64* m_rbuff64;
 
 	__aligned(struct, 32) WriteState
 	{
 		GIFRegTEX0 TEX0;
 		GIFRegTEXCLUT TEXCLUT;
 		bool dirty;
+		int entry;
 		bool IsDirty(const GIFRegTEX0& TEX0, const GIFRegTEXCLUT& TEXCLUT);
 	} m_write;
 
@@ -52,10 +58,44 @@ __aligned(class, 32) GSClut : public GSAlignedClass<32>
 		bool dirty;
 		bool adirty;
 		int amin, amax;
+		int entry;
 		bool IsDirty(const GIFRegTEX0& TEX0);
 		bool IsDirty(const GIFRegTEX0& TEX0, const GIFRegTEXA& TEXA);
 	} m_read;
 
+	// m_clut is split into 64 slots of 16 entries, each slot remembers the load that filled it last,
+	// a load is only repeated if its source pages were written since or another load overwrote its slots
+
+	enum {SLOTS = 64, PAGES = MAX_PAGES / 32, WRITE_CACHE = 16, READ_CACHE = 8};
+
+	uint32 m_slot[SLOTS];
+	uint32 m_load;
+	uint32 m_clock;
+	uint32 m_deps[PAGES];
+
+	struct WriteEntry
+	{
+		GIFRegTEX0 TEX0;
+		GIFRegTEXCLUT TEXCLUT;
+		uint32 pages[PAGES];
+		uint32 id;
+		uint32 used;
+		bool valid;
+	} m_wcache[WRITE_CACHE];
+
+	struct ReadEntry
+	{
+		GIFRegTEX0 TEX0;
+		GIFRegTEXA TEXA;
+		uint32 slot[SLOTS / 2];
+		uint32* buff32;
+		uint64* buff64;
+		uint32 used;
+		bool valid;
+		bool adirty;
+		int amin, amax;
+	} m_rcache[READ_CACHE];
+
 	typedef void (GSClut::*writeCLUT)(const GIFRegTEX0& TEX0, const GIFRegTEXCLUT& TEXCLUT);
 
 	writeCLUT m_wc[2][16][64];
@@ -92,11 +132,22 @@ __aligned(class, 32) GSClut : public GSAlignedClass<32>
 
 	static void Expand16(const uint16* RESTRICT src, uint32* RESTRICT dst, int w, const GIFRegTEXA& TEXA);
 
+	static void GetKey(const GIFRegTEX0& TEX0, const GIFRegTEXCLUT& TEXCLUT, GIFRegTEX0& key, GIFRegTEXCLUT& keyclut);
+	static void GetSlots(const GIFRegTEX0& TEX0, int& first, int& count, bool& dual);
+	static void GetPages(uint32* RESTRICT pages, uint32 bp, uint32 bw, uint32 psm, const GSVector4i& r);
+
+	bool IsValid(const WriteEntry& e) const;
+	bool IsValid(const ReadEntry& e) const;
+	void UpdateDeps();
+
 public:
 	GSClut(GSLocalMemory* mem);
 	virtual ~GSClut();
 
+	void SetPerfMon(GSPerfMon* perfmon) {m_perfmon = perfmon;}
+
 	void Invalidate();
+	void Invalidate(uint32 bp, uint32 bw, uint32 psm, const GSVector4i& r);
 	bool WriteTest(const GIFRegTEX0& TEX0, const GIFRegTEXCLUT& TEXCLUT);
 	void Write(const GIFRegTEX0& TEX0, const GIFRegTEXCLUT& TEXCLUT);
 	void Read(const GIFRegTEX0& TEX0);
@@ -1481,6 +1481,34 @@ void GSDrawScanline::DrawRectT(const int* RESTRICT row, const int* RESTRICT col,
 
 	color = color.andnot(mask);
 
+	if(!masked)
+	{
+		// 32x16 pixels are 2x2 or 4x2 continuous blocks in every format, when all of it gets the same value 
+		// the swizzling does not matter, and it is still within the 16 lines a rasterizer thread owns
+
+		GSVector4i pr = r.ralign<Align_Inside>(GSVector2i(32, 16));
+
+		if(!pr.rempty())
+		{
+			FillRun<T>(row, col, pr, color);
+
+			DrawBlockT<T, masked>(row, col, GSVector4i(r.x, r.y, r.z, pr.y), c, m, color, mask);
+			DrawBlockT<T, masked>(row, col, GSVector4i(r.x, pr.w, r.z, r.w), c, m, color, mask);
+			DrawBlockT<T, masked>(row, col, GSVector4i(r.x, pr.y, pr.x, pr.w), c, m, color, mask);
+			DrawBlockT<T, masked>(row, col, GSVector4i(pr.z, pr.y, r.z, pr.w), c, m, color, mask);
+
+			return;
+		}
+	}
+
+	DrawBlockT<T, masked>(row, col, r, c, m, color, mask);
+}
+
+template<class T, bool masked>
+void GSDrawScanline::DrawBlockT(const int* RESTRICT row, const int* RESTRICT col, const GSVector4i& r, uint32 c, uint32 m, const GSVector4i& color, const GSVector4i& mask)
+{
+	if(r.rempty()) return;
+
 	GSVector4i br = r.ralign<Align_Inside>(GSVector2i(8 * 4 / sizeof(T), 8));
 
 	if(!br.rempty())
@@ -1545,3 +1573,29 @@ void GSDrawScanline::FillBlock(const int* RESTRICT row, const int* RESTRICT col,
 		}
 	}
 }
+
+template<class T>
+void GSDrawScanline::FillRun(const int* RESTRICT row, const int* RESTRICT col, const GSVector4i& r, const GSVector4i& c)
+{
+	T* vm = (T*)m_global.vm;
+
+	for(int y = r.y; y < r.w; y += 16)
+	{
+		for(int x = r.x; x < r.z; x += 32)
+		{
+			GSVector4i* RESTRICT p = (GSVector4i*)&vm[(row[y] + col[x]) & ~511];
+
+			for(int i = 0; i < 32 * sizeof(T); i += 8)
+			{
+				p[i + 0] = c;
+				p[i + 1] = c;
+				p[i + 2] = c;
+				p[i + 3] = c;
+				p[i + 4] = c;
+				p[i + 5] = c;
+				p[i + 6] = c;
+				p[i + 7] = c;
+			}
+		}
+	}
+}
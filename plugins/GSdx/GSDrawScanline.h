@@ -38,12 +38,18 @@ class GSDrawScanline : public IDrawScanline
 	template<class T, bool masked>
 	void DrawRectT(const int* RESTRICT row, const int* RESTRICT col, const GSVector4i& r, uint32 c, uint32 m);
 
+	template<class T, bool masked>
+	void DrawBlockT(const int* RESTRICT row, const int* RESTRICT col, const GSVector4i& r, uint32 c, uint32 m, const GSVector4i& color, const GSVector4i& mask);
+
 	template<class T, bool masked>
 	__forceinline void FillRect(const int* RESTRICT row, const int* RESTRICT col, const GSVector4i& r, uint32 c, uint32 m);
 
 	template<class T, bool masked>
 	__forceinline void FillBlock(const int* RESTRICT row, const int* RESTRICT col, const GSVector4i& r, const GSVector4i& c, const GSVector4i& m);
 
+	template<class T>
+	__forceinline void FillRun(const int* RESTRICT row, const int* RESTRICT col, const GSVector4i& r, const GSVector4i& c);
+
 public:
 	GSDrawScanline();
 	virtual ~GSDrawScanline();
@@ -21,6 +21,7 @@
 
 #include "stdafx.h"
 #include "GSDrawScanlineCodeGenerator.h"
+#include "GSdx.h"
 
 const GSVector4i GSDrawScanlineCodeGenerator::m_test[8] =
 {
@@ -48,6 +49,10 @@ GSDrawScanlineCodeGenerator::GSDrawScanlineCodeGenerator(void* param, uint64 key
 {
 	m_sel.key = key;
 
+	// AVX2 gathers are only used by the AVX generator. Off by default until GSFunctionMap::PrintStats
+	// shows them beating the scalar fetches; set avx2=1 in the ini to compare both paths.
+	m_gather = m_cpu.has(util::Cpu::tAVX2) && !!theApp.GetConfig("avx2", 0);
+
 	Generate();
 }
 
@@ -32,6 +32,7 @@ class GSDrawScanlineCodeGenerator : public GSCodeGenerator
 
 	GSScanlineSelector m_sel;
 	GSScanlineLocalData& m_local;
+	bool m_gather;
 
 	void Generate();
 
@@ -64,6 +65,7 @@ class GSDrawScanlineCodeGenerator : public GSCodeGenerator
 	void ReadPixel(const Xmm& dst, const Reg32& addr);
 	void WritePixel(const Xmm& src, const Reg32& addr, const Reg8& mask, bool fast, int psm, int fz);
 	void WritePixel(const Xmm& src, const Reg32& addr, uint8 i, int psm);
+	void gather32(const Xmm& dst, const Reg32& base, const Xmm& index, const Xmm& mask);
 	#endif
 
 	void ReadTexel(int pixels, int mip_offset = 0);
@@ -2808,6 +2808,23 @@ void GSDrawScanlineCodeGenerator::ReadTexel(int pixels, int mip_offset)
 
 		const int r[] = {5, 6, 2, 4, 0, 1, 3, 5};
 
+		if(m_gather && pixels == 4 && !m_sel.tlu)
+		{
+			// xmm1, xmm4, xmm6 are free on entry, and each address register is free again once
+			// it has been gathered from, which leaves a spare register for every gather mask
+
+			const int m[] = {1, 1, 5, 0};
+
+			for(int i = 0; i < 4; i++)
+			{
+				vpcmpeqd(Xmm(m[i]), Xmm(m[i]));
+
+				gather32(Xmm(r[i * 2 + 1]), ebx, Xmm(r[i * 2 + 0]), Xmm(m[i]));
+			}
+
+			return;
+		}
+
 		for(int i = 0; i < pixels; i++)
 		{
 			for(int j = 0; j < 4; j++)
@@ -2818,6 +2835,34 @@ void GSDrawScanlineCodeGenerator::ReadTexel(int pixels, int mip_offset)
 	}
 }
 
+void GSDrawScanlineCodeGenerator::gather32(const Xmm& dst, const Reg32& base, const Xmm& index, const Xmm& mask)
+{
+	// vpgatherdd dst, [base + index * 4], mask
+
+	// the bundled xbyak cannot encode vsib operands, so the instruction is assembled here;
+	// dst, index and mask must be three different registers, mask is cleared on completion
+
+	ASSERT(dst.getIdx() != index.getIdx() && dst.getIdx() != mask.getIdx() && index.getIdx() != mask.getIdx());
+
+	db(0xc4);
+	db(0xe2); // ~R ~X ~B, 0F38
+	db(((~mask.getIdx() & 15) << 3) | 1); // W0 vvvv L0 66
+
+	db(0x90);
+
+	if(base.getIdx() == Operand::EBP)
+	{
+		db(0x44 | (dst.getIdx() << 3)); // [sib + disp8]
+		db(0x80 | (index.getIdx() << 3) | base.getIdx());
+		db(0);
+	}
+	else
+	{
+		db(0x04 | (dst.getIdx() << 3)); // [sib]
+		db(0x80 | (index.getIdx() << 3) | base.getIdx());
+	}
+}
+
 void GSDrawScanlineCodeGenerator::ReadTexel(const Xmm& dst, const Xmm& addr, uint8 i)
 {
 	const Address& src = m_sel.tlu ? ptr[edx + eax * 4] : ptr[ebx + eax * 4];
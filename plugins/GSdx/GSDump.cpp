@@ -97,7 +97,7 @@ void GSDump::VSync(int field, bool last, const GSPrivRegSet* regs)
 	}
 }
 
-void GSDump::Object(GSVertexSW* vertices, int count, GS_PRIM_CLASS primclass)
+void GSDump::Object(GSVertexSW* vertices, int count, const uint32* index, int index_count, GS_PRIM_CLASS primclass)
 {
 	if(m_obj)
 	{
@@ -138,11 +138,11 @@ void GSDump::Object(GSVertexSW* vertices, int count, GS_PRIM_CLASS primclass)
 
 			fprintf(m_obj, "g f%d_o%d_p%d_v%d\n", m_frames, m_objects, primclass, count);
 
-			for(int i = 0; i < count; i += 3)
+			for(int i = 0, n = index != NULL ? index_count : count; i < n; i += 3)
 			{
-				int a = m_vertices + i + 1;
-				int b = m_vertices + i + 2;
-				int c = m_vertices + i + 3;
+				int a = m_vertices + (index != NULL ? index[i + 0] : i + 0) + 1;
+				int b = m_vertices + (index != NULL ? index[i + 1] : i + 1) + 1;
+				int c = m_vertices + (index != NULL ? index[i + 2] : i + 2) + 1;
 
 				fprintf(m_obj, "f %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, c, c, c);
 			}
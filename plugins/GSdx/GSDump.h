@@ -60,6 +60,6 @@ public:
 	void ReadFIFO(uint32 size);
 	void Transfer(int index, const uint8* mem, size_t size);
 	void VSync(int field, bool last, const GSPrivRegSet* regs);
-	void Object(GSVertexSW* vertices, int count, GS_PRIM_CLASS primclass);
+	void Object(GSVertexSW* vertices, int count, const uint32* index, int index_count, GS_PRIM_CLASS primclass);
 	operator bool() {return m_gs != NULL;}
 };
@@ -35,8 +35,10 @@ public:
 	
 	enum counter_t 
 	{
-		Frame, Prim, Draw, Swizzle, Unswizzle, Fillrate, Quad, 
-		CounterLast,
+		Frame, Prim, Draw, Swizzle, SwizzleAsync, Unswizzle, Fillrate, Quad, ClutLoad, ClutCached, Vertex, VertexShared, DrawMerged, SolidRect, Alloc, AllocPooled, AllocTicks, UnswizzleAsync, UnswizzleTicks, 
+		SyncReason0, SyncReason1, SyncReason2, SyncReason3, SyncReason4, SyncReason5, SyncReason6, SyncReason7, 
+		SyncReason8, SyncReason9, SyncReasonLast = SyncReason9 + 1,
+		CounterLast = SyncReasonLast,
 	};
 
 protected:
@@ -98,6 +98,11 @@ int GSRasterizer::FindMyNextScanline(int top) const
 
 void GSRasterizer::Queue(shared_ptr<GSRasterizerData> data)
 {
+	if(data->barrier)
+	{
+		data->remaining = 1;
+	}
+
 	Draw(data);
 }
 
@@ -105,6 +110,28 @@ void GSRasterizer::Draw(shared_ptr<GSRasterizerData> data)
 {
 	GSPerfMonAutoTimer pmat(m_perfmon, GSPerfMon::WorkerDraw0 + m_id);
 
+	if(data->dependency)
+	{
+		// the other workers are ahead of or at the same point in the queue, it cannot be waiting for us
+
+		while(data->dependency->remaining > 0)
+		{
+			_mm_pause();
+		}
+	}
+
+	if(data->transfer)
+	{
+		Transfer(data.get());
+
+		if(data->barrier)
+		{
+			_InterlockedDecrement(&data->remaining);
+		}
+
+		return;
+	}
+
 	if(data->count == 0) return;
 
 	m_ds->BeginDraw(data->param);
@@ -145,9 +172,22 @@ void GSRasterizer::Draw(shared_ptr<GSRasterizerData> data)
 		break;
 
 	case GS_TRIANGLE_CLASS:
-		
-		do {DrawTriangle(vertices); vertices += 3;}
-		while(vertices < vertices_end);
+
+		if(data->index != NULL)
+		{
+			const uint32* index = data->index;
+			const uint32* index_end = data->index + data->index_count;
+
+			do {DrawTriangle(vertices, index); index += 3;}
+			while(index < index_end);
+		}
+		else
+		{
+			static const uint32 s_index[3] = {0, 1, 2};
+
+			do {DrawTriangle(vertices, s_index); vertices += 3;}
+			while(vertices < vertices_end);
+		}
 
 		break;
 
@@ -167,9 +207,42 @@ void GSRasterizer::Draw(shared_ptr<GSRasterizerData> data)
 	_InterlockedExchangeAdd(&data->ticks, (long)ticks);
 	_InterlockedExchangeAdd(&data->pixels, m_pixels);
 
+	if(data->trace != NULL && m_id < GSTRACE_WORKERS)
+	{
+		GSTraceDraw* t = data->trace;
+
+		t->worker[m_id].start = (uint32)(start - t->tsc);
+		t->worker[m_id].ticks = (uint32)ticks;
+		t->worker[m_id].pixels = m_pixels;
+	}
+
 	m_ds->EndDraw(data->frame, ticks, m_pixels);
 }
 
+void GSRasterizer::Transfer(GSRasterizerData* data)
+{
+	int top = data->bbox.top;
+	int bottom = data->bbox.bottom;
+
+	while(top < bottom)
+	{
+		top = FindMyNextScanline(top);
+
+		if(top >= bottom) break;
+
+		int next = top;
+
+		do {next = (next + (1 << THREAD_HEIGHT)) & ~((1 << THREAD_HEIGHT) - 1);}
+		while(next < bottom && IsOneOfMyScanlines(next));
+
+		next = std::min<int>(next, bottom);
+
+		data->Transfer(top, next);
+
+		top = next;
+	}
+}
+
 template<bool scissor_test>
 void GSRasterizer::DrawPoint(const GSVertexSW* v, int count)
 {
@@ -303,7 +376,7 @@ static const uint8 s_ysort[8][4] =
 	{2, 1, 0, 0}, // y2 < y1 < y0
 };
 
-void GSRasterizer::DrawTriangle(const GSVertexSW* vertices)
+void GSRasterizer::DrawTriangle(const GSVertexSW* vertex, const uint32* index)
 {
 	GSVertexSW v[3];
 	GSVertexSW dv[3];
@@ -311,14 +384,16 @@ void GSRasterizer::DrawTriangle(const GSVertexSW* vertices)
 	GSVertexSW dedge;
 	GSVertexSW dscan;
 
-	GSVector4 y0011 = vertices[0].p.yyyy(vertices[1].p);
-	GSVector4 y1221 = vertices[1].p.yyyy(vertices[2].p).xzzx();
+	const GSVertexSW* vertices[3] = {&vertex[index[0]], &vertex[index[1]], &vertex[index[2]]};
+
+	GSVector4 y0011 = vertices[0]->p.yyyy(vertices[1]->p);
+	GSVector4 y1221 = vertices[1]->p.yyyy(vertices[2]->p).xzzx();
 
 	int mask = (y0011 > y1221).mask() & 7;
 
-	v[0] = vertices[s_ysort[mask][0]];
-	v[1] = vertices[s_ysort[mask][1]];
-	v[2] = vertices[s_ysort[mask][2]];
+	v[0] = *vertices[s_ysort[mask][0]];
+	v[1] = *vertices[s_ysort[mask][1]];
+	v[2] = *vertices[s_ysort[mask][2]];
 
 	y0011 = v[0].p.yyyy(v[1].p);
 	y1221 = v[1].p.yyyy(v[2].p).xzzx();
@@ -878,6 +953,11 @@ void GSRasterizerList::Sync()
 
 void GSRasterizerList::Process(shared_ptr<GSRasterizerData>& item)
 {
+	if(item->barrier)
+	{
+		item->remaining = m_workers.size();
+	}
+
 	if(item->solidrect)
 	{
 		m_solidrect_count++;
@@ -930,7 +1010,7 @@ void GSRasterizerList::GSWorker::Push(const shared_ptr<GSRasterizerData>& item)
 {
 	GSVector4i r = item->bbox.rintersect(item->scissor);
 
-	if(m_r->IsOneOfMyScanlines(r.top, r.bottom))
+	if(item->barrier || m_r->IsOneOfMyScanlines(r.top, r.bottom))
 	{
 		GSJobQueue<shared_ptr<GSRasterizerData> >::Push(item);
 	}
@@ -27,6 +27,7 @@
 #include "GSThread.h"
 #include "GSAlignedClass.h"
 #include "GSPerfMon.h"
+#include "GSTrace.h"
 
 __aligned(class, 32) GSRasterizerData : public GSAlignedClass<32>
 {
@@ -36,10 +37,17 @@ public:
 	GS_PRIM_CLASS primclass;
 	GSVertexSW* vertices;
 	int count;
+	uint32* index; // triangles only, NULL if the vertices follow each other
+	int index_count;
 	bool solidrect;
 	bool syncpoint;
+	bool transfer; // not a draw, Transfer is called with the rows of bbox owned by the worker
+	bool barrier; // transfers only, every worker gets it, even without rows in bbox
+	volatile long remaining; // barrier: the workers that are not done with it yet
+	shared_ptr<GSRasterizerData> dependency; // a barrier queued earlier, all workers must be done with it before this starts
 	uint64 frame;
 	void* param;
+	GSTraceDraw* trace; // NULL if tracing is off
 
 	// drawing stats
 
@@ -52,10 +60,16 @@ public:
 		, primclass(GS_INVALID_CLASS)
 		, vertices(NULL)
 		, count(0)
+		, index(NULL)
+		, index_count(0)
 		, solidrect(false)
 		, syncpoint(false)
+		, transfer(false)
+		, barrier(false)
+		, remaining(0)
 		, frame(0)
 		, param(NULL)
+		, trace(NULL)
 		, ticks(0)
 		, pixels(0)
 	{
@@ -64,9 +78,15 @@ public:
 	virtual ~GSRasterizerData() 
 	{
 		if(vertices != NULL) _aligned_free(vertices);
+		if(index != NULL) _aligned_free(index);
 
 		// derived class should free param and its members
 	}
+
+	// rows are split between the workers the same way scanlines are, so a transfer stays
+	// ordered with the draws queued before and after it to the same area
+
+	virtual void Transfer(int top, int bottom) {}
 };
 
 class IDrawScanline : public GSAlignedClass<32>
@@ -136,8 +156,9 @@ protected:
 	template<bool scissor_test> 
 	void DrawPoint(const GSVertexSW* v, int count);
 	void DrawLine(const GSVertexSW* v);
-	void DrawTriangle(const GSVertexSW* v);
+	void DrawTriangle(const GSVertexSW* vertex, const uint32* index);
 	void DrawSprite(const GSVertexSW* v, bool solidrect);
+	void Transfer(GSRasterizerData* data);
 
 	__forceinline void DrawTriangleSection(int top, int bottom, GSVertexSW& edge, const GSVertexSW& dedge, const GSVertexSW& dscan, const GSVector4& p0);
 
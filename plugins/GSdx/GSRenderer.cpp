@@ -350,6 +350,65 @@ void GSRenderer::VSync(int field)
 				s += format(" | %.2f mpps", fps * fillrate / (1024 * 1024));
 			}
 
+			double swizzle = m_perfmon.Get(GSPerfMon::SwizzleAsync);
+
+			if(swizzle > 0)
+			{
+				s += format(" | %.2f MB/s threaded swizzle", fps * swizzle / (1024 * 1024));
+			}
+
+			double unswizzle = m_perfmon.Get(GSPerfMon::UnswizzleAsync);
+
+			if(unswizzle > 0)
+			{
+				s += format(" | %.2f MB/s threaded unswizzle, %d kcycles", fps * unswizzle / (1024 * 1024), (int)(m_perfmon.Get(GSPerfMon::UnswizzleTicks) / 1000));
+			}
+
+			double vertex = m_perfmon.Get(GSPerfMon::Vertex);
+
+			if(vertex > 0)
+			{
+				s += format(" | %d%% shared vertices, %d merged draws", (int)(100 * m_perfmon.Get(GSPerfMon::VertexShared) / vertex), (int)m_perfmon.Get(GSPerfMon::DrawMerged));
+			}
+
+			double solidrect = m_perfmon.Get(GSPerfMon::SolidRect);
+
+			if(solidrect > 0)
+			{
+				s += format(" | %d fills", (int)solidrect);
+			}
+
+			string syncs;
+
+			for(int i = GSPerfMon::SyncReason0; i < GSPerfMon::SyncReasonLast; i++)
+			{
+				double n = m_perfmon.Get((GSPerfMon::counter_t)i);
+
+				if(n > 0)
+				{
+					syncs += format(" %d:%.1f", i - GSPerfMon::SyncReason0, n);
+				}
+			}
+
+			if(!syncs.empty())
+			{
+				s += " | sync" + syncs;
+			}
+
+			double alloc = m_perfmon.Get(GSPerfMon::Alloc);
+
+			if(alloc > 0)
+			{
+				s += format(" | %d/%d pooled allocs, %d kcycles", (int)m_perfmon.Get(GSPerfMon::AllocPooled), (int)alloc, (int)(m_perfmon.Get(GSPerfMon::AllocTicks) / 1000));
+			}
+
+			double clut = m_perfmon.Get(GSPerfMon::ClutCached);
+
+			if(clut > 0)
+			{
+				s += format(" | %d/%d clut", (int)clut, (int)(clut + m_perfmon.Get(GSPerfMon::ClutLoad)));
+			}
+
 		}
 		else
 		{
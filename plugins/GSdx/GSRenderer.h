@@ -126,7 +126,9 @@ protected:
 
 			if(!m_dev->IsLost())
 			{
-				m_vt.Update(m_vertices, m_count, GSUtil::GetPrimClass(PRIM->PRIM));
+				UpdateVertexTrace();
+
+				InvalidateClut(GSVector4i(m_vt.m_min.p.floor().xyxy(m_vt.m_max.p.ceil())).rintersect(GSVector4i(m_context->scissor.in)));
 
 				Draw();
 			}
@@ -231,6 +233,11 @@ protected:
 		return !skip ? v : NULL;
 	}
 
+	virtual void UpdateVertexTrace()
+	{
+		m_vt.Update(m_vertices, m_count, GSUtil::GetPrimClass(PRIM->PRIM));
+	}
+
 	virtual void Draw() = 0;
 
 public:
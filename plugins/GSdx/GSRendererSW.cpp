@@ -26,11 +26,27 @@ const GSVector4 g_pos_scale(1.0f / 16, 1.0f / 16, 1.0f, 128.0f);
 
 GSRendererSW::GSRendererSW(int threads)
 	: m_fzb(NULL)
+	, m_write_count(0)
+	, m_write_offset(NULL)
+	, m_index(NULL)
+	, m_index_count(0)
+	, m_index_maxcount(0)
+	, m_pool(&m_perfmon)
+	, m_prefetch(threads > 1)
 {
 	InitVertexKick(GSRendererSW);
 
+	ResetBounds();
+
 	m_tc = new GSTextureCacheSW(this);
 
+	string trace = theApp.GetConfig("trace", "");
+
+	if(!trace.empty())
+	{
+		m_trace.Open(trace);
+	}
+
 	memset(m_texture, 0, sizeof(m_texture));
 
 	m_rl = GSRasterizerList::Create<GSDrawScanline>(threads, &m_perfmon);
@@ -43,6 +59,13 @@ GSRendererSW::GSRendererSW(int threads)
 
 GSRendererSW::~GSRendererSW()
 {
+	// VSync doesn't wait for the workers, the queued draws still use the textures and pages freed below
+
+	m_rl->Sync();
+
+	m_pending.reset();
+	m_last_update.reset(); // releases the pages of its texture, must go before m_tc
+
 	delete m_tc;
 
 	for(int i = 0; i < countof(m_texture); i++)
@@ -53,6 +76,8 @@ GSRendererSW::~GSRendererSW()
 	delete m_rl;
 
 	_aligned_free(m_output);
+
+	if(m_index) _aligned_free(m_index);
 }
 
 void GSRendererSW::Reset()
@@ -67,7 +92,20 @@ void GSRendererSW::Reset()
 
 void GSRendererSW::VSync(int field)
 {
-	Sync(0); // IncAge might delete a cached texture in use
+	// the workers may finish this frame while the next one is parsed, reading the output, transfers
+	// and textures only wait if their pages are still being drawn to
+
+	QueuePending();
+
+	if(m_reset || m_trace)
+	{
+		Sync(0);
+
+		if(m_trace)
+		{
+			m_trace.Flush(m_perfmon.GetFrame());
+		}
+	}
 
 	/*
 	int draw[8], sum = 0;
@@ -90,7 +128,7 @@ void GSRendererSW::VSync(int field)
 */	
 	GSRendererT<GSVertexSW>::VSync(field);
 
-	m_tc->IncAge();
+	m_tc->IncAge(m_tex_pages); // keeps the textures of the queued draws
 
 	if(m_reset)
 	{
@@ -102,6 +140,59 @@ void GSRendererSW::VSync(int field)
 	// if((m_perfmon.GetFrame() & 255) == 0) m_rl.PrintStats();
 }
 
+static uint64 Hash(uint64 h, const void* src, int size)
+{
+	// FNV-1a over 64-bit words
+
+	const uint64* p = (const uint64*)src;
+
+	for(int i = 0, n = size >> 3; i < n; i++)
+	{
+		h = (h ^ p[i]) * 0x100000001b3ull;
+	}
+
+	return h;
+}
+
+void GSRendererSW::VSyncHash(uint64& vm, uint64& out)
+{
+	// the regression harness (GSReplayHash) has no window, this is VSync without merging and presenting,
+	// the hashes are taken after the workers finished everything queued for the frame
+
+	m_perfmon.Put(GSPerfMon::Frame);
+
+	Flush();
+
+	Sync(0);
+
+	vm = Hash(0xcbf29ce484222325ull, m_mem.m_vm8, m_mem.m_vmsize);
+
+	out = 0xcbf29ce484222325ull;
+
+	for(int i = 0; i < 2; i++)
+	{
+		if(IsEnabled(i) && GetOutput(i) != NULL)
+		{
+			int w = m_regs->DISP[i].DISPFB.FBW * 64;
+			int h = GetFrameRect(i).bottom;
+
+			for(int y = 0; y < h; y++)
+			{
+				out = Hash(out, &m_output[y * 1024 * 4], std::min<int>(w, 1024) * 4);
+			}
+		}
+	}
+
+	m_tc->IncAge(m_tex_pages);
+
+	if(m_reset)
+	{
+		m_tc->RemoveAll();
+
+		m_reset = false;
+	}
+}
+
 void GSRendererSW::ResetDevice()
 {
 	for(int i = 0; i < countof(m_texture); i++)
@@ -114,8 +205,6 @@ void GSRendererSW::ResetDevice()
 
 GSTexture* GSRendererSW::GetOutput(int i)
 {
-	Sync(1);
-
 	const GSRegDISPFB& DISPFB = m_regs->DISP[i].DISPFB;
 
 	int w = DISPFB.FBW * 64;
@@ -131,7 +220,25 @@ GSTexture* GSRendererSW::GetOutput(int i)
 
 		const GSLocalMemory::psm_t& psm = GSLocalMemory::m_psm[DISPFB.PSM];
 
-		(m_mem.*psm.rtx)(m_mem.GetOffset(DISPFB.Block(), DISPFB.FBW, DISPFB.PSM), r.ralign<Align_Outside>(psm.bs), m_output, pitch, m_env.TEXA);
+		GSOffset* o = m_mem.GetOffset(DISPFB.Block(), DISPFB.FBW, DISPFB.PSM);
+
+		// usually the next frame is being drawn into the other buffer
+
+		vector<uint32>* pages = o->GetPages(r.ralign<Align_Outside>(psm.bs));
+
+		for(vector<uint32>::const_iterator j = pages->begin(); j != pages->end(); j++)
+		{
+			if(m_fzb_pages[*j])
+			{
+				Sync(1);
+
+				break;
+			}
+		}
+
+		delete pages;
+
+		(m_mem.*psm.rtx)(o, r.ralign<Align_Outside>(psm.bs), m_output, pitch, m_env.TEXA);
 
 		m_texture[i]->Update(r, m_output, pitch);
 
@@ -151,7 +258,7 @@ GSTexture* GSRendererSW::GetOutput(int i)
 
 void GSRendererSW::Draw()
 {
-	if(m_dump) m_dump.Object(m_vertices, m_count, m_vt.m_primclass);
+	if(m_dump) m_dump.Object(m_vertices, m_count, m_index, m_index_count, m_vt.m_primclass);
 
 	GSVector4i scissor = GSVector4i(m_context->scissor.in);
 	GSVector4i bbox = GSVector4i(m_vt.m_min.p.floor().xyxy(m_vt.m_max.p.ceil()));
@@ -164,6 +271,9 @@ void GSRendererSW::Draw()
 
 	GSRasterizerData2* data2 = (GSRasterizerData2*)data.get();
 
+	int tex_hit = m_tc->m_lookups.hit;
+	int tex_miss = m_tc->m_lookups.miss;
+
 	if(!GetScanlineGlobalData(data2))
 	{
 		return;
@@ -171,12 +281,22 @@ void GSRendererSW::Draw()
 
 	GSScanlineGlobalData* gd = (GSScanlineGlobalData*)data->param;
 
+	data->dependency = GetLastUpdate();
+
 	data->scissor = scissor;
 	data->bbox = bbox;
 	data->primclass = m_vt.m_primclass;
-	data->vertices = (GSVertexSW*)_aligned_malloc(sizeof(GSVertexSW) * m_count, 16); // TODO: detach m_vertices and reallocate later?
+	data->vertices = (GSVertexSW*)m_pool.Alloc(sizeof(GSVertexSW) * m_count); // TODO: detach m_vertices and reallocate later?
 	memcpy(data->vertices, m_vertices, sizeof(GSVertexSW) * m_count); // TODO: m_vt.Update fetches all the vertices already, could also store them here
 	data->count = m_count;
+
+	if(data->primclass == GS_TRIANGLE_CLASS)
+	{
+		data->index = (uint32*)m_pool.Alloc(sizeof(uint32) * m_index_count);
+		memcpy(data->index, m_index, sizeof(uint32) * m_index_count);
+		data->index_count = m_index_count;
+	}
+
 	data->solidrect = gd->sel.IsSolidRect();
 	data->frame = m_perfmon.GetFrame();
 
@@ -243,10 +363,78 @@ void GSRendererSW::Draw()
 		}
 	}
 
+	// image transfers still on the workers are only ordered with draws into the same layout (the
+	// same rows end up on the same worker), anything else writing to their pages has to wait for
+	// them; z-buffer pages are already covered by the check above
+
+	if(!data->syncpoint && m_write_count > 0)
+	{
+		if(gd->sel.fwrite && m_context->offset.fb != m_write_offset)
+		{
+			for(vector<uint32>::iterator i = fb_pages->begin(); i != fb_pages->end(); i++)
+			{
+				if(m_fzb_pages[*i] & 0x0000ffff)
+				{
+					data->syncpoint = true;
+
+					break;
+				}
+			}
+		}
+	}
+
 	//
 
 	data2->UseTargetPages(fb_pages, zb_pages);
 
+	int prims = 0;
+	int refs = data->primclass == GS_TRIANGLE_CLASS ? data->index_count : data->count;
+
+	switch(data->primclass)
+	{
+	case GS_POINT_CLASS: prims = refs; break;
+	case GS_LINE_CLASS: prims = refs / 2; break;
+	case GS_TRIANGLE_CLASS: prims = refs / 3; break;
+	case GS_SPRITE_CLASS: prims = refs / 2; break;
+	}
+
+	m_perfmon.Put(GSPerfMon::Prim, prims);
+	m_perfmon.Put(GSPerfMon::Vertex, refs);
+	m_perfmon.Put(GSPerfMon::VertexShared, refs - data->count);
+
+	if(data->solidrect)
+	{
+		m_perfmon.Put(GSPerfMon::SolidRect, 1);
+	}
+
+	if(m_trace)
+	{
+		if(m_trace.IsFull())
+		{
+			Sync(8);
+
+			m_trace.Flush(m_perfmon.GetFrame());
+		}
+
+		GSTraceDraw* t = m_trace.Add();
+
+		t->sel = gd->sel.key;
+		t->tsc = __rdtsc();
+		t->frame = (uint32)data->frame;
+		t->primclass = (uint16)data->primclass;
+		t->flags = (data->solidrect ? GSTRACE_SOLIDRECT : 0) | (data->syncpoint ? GSTRACE_SYNCPOINT : 0);
+		t->count = data->count;
+		t->prims = prims;
+		t->bbox[0] = (int16)r.left;
+		t->bbox[1] = (int16)r.top;
+		t->bbox[2] = (int16)r.right;
+		t->bbox[3] = (int16)r.bottom;
+		t->tex_hit = (uint16)(m_tc->m_lookups.hit - tex_hit);
+		t->tex_miss = (uint16)(m_tc->m_lookups.miss - tex_miss);
+
+		data->trace = t;
+	}
+
 	//
 
 	if(s_dump)
@@ -304,20 +492,32 @@ void GSRendererSW::Draw()
 	}
 	else
 	{
-		m_rl->Queue(data);
-	}
+		// small draws with the same state are often cut apart by register writes that did not change
+		// anything in the end (clut reloads, texture flushes), workers pay the setup for each of them
 
-	int prims = 0;
-	
-	switch(data->primclass)
-	{
-	case GS_POINT_CLASS: prims = data->count; break;
-	case GS_LINE_CLASS: prims = data->count / 2; break;
-	case GS_TRIANGLE_CLASS: prims = data->count / 3; break;
-	case GS_SPRITE_CLASS: prims = data->count / 2; break;
-	}
+		if(m_pending && !data->syncpoint && ((GSRasterizerData2*)m_pending.get())->Merge(data, GSLocalMemory::m_psm[m_context->TEX0.PSM].pal))
+		{
+			m_perfmon.Put(GSPerfMon::DrawMerged, 1);
 
-	m_perfmon.Put(GSPerfMon::Prim, prims);
+			if(data->trace != NULL)
+			{
+				data->trace->flags |= GSTRACE_MERGED;
+			}
+		}
+		else
+		{
+			QueuePending();
+
+			if(refs <= 64)
+			{
+				m_pending = data;
+			}
+			else
+			{
+				m_rl->Queue(data);
+			}
+		}
+	}
 
 	/*
 	if(0)//stats.ticks > 5000000)
@@ -337,7 +537,26 @@ void GSRendererSW::Sync(int reason)
 
 	GSPerfMonAutoTimer pmat(&m_perfmon, GSPerfMon::Sync);
 
+	if(reason >= 0 && reason < GSPerfMon::SyncReasonLast - GSPerfMon::SyncReason0)
+	{
+		m_perfmon.Put((GSPerfMon::counter_t)(GSPerfMon::SyncReason0 + reason), 1);
+	}
+
+	QueuePending();
+
 	m_rl->Sync();
+
+	m_last_update.reset();
+}
+
+void GSRendererSW::QueuePending()
+{
+	if(m_pending)
+	{
+		m_rl->Queue(m_pending);
+
+		m_pending.reset();
+	}
 }
 
 void GSRendererSW::InvalidateVideoMem(const GIFRegBITBLTBUF& BITBLTBUF, const GSVector4i& r)
@@ -348,6 +567,8 @@ void GSRendererSW::InvalidateVideoMem(const GIFRegBITBLTBUF& BITBLTBUF, const GS
 
 	m_tc->InvalidatePages(pages, o->psm);
 
+	GetLastUpdate(); // a finished update still holds its texture pages
+
 	// check if the changing pages either used as a texture or a target
 
 	for(vector<uint32>::const_iterator i = pages->begin(); i != pages->end(); i++)
@@ -388,6 +609,59 @@ void GSRendererSW::InvalidateLocalMem(const GIFRegBITBLTBUF& BITBLTBUF, const GS
 	delete pages;
 }
 
+bool GSRendererSW::WriteImageAsync(const uint8* src, int len, const GSVector4i& r)
+{
+	// small transfers are cheaper to swizzle right here than to queue
+
+	if(len < 64 * 1024) return false;
+
+	const GSLocalMemory::psm_t& psm = GSLocalMemory::m_psm[m_env.BITBLTBUF.DPSM];
+
+	// the workers split by whole rows, and only know about the first 2048 scanlines
+
+	int bits = r.width() * psm.trbpp;
+
+	if(r.bottom > 2048 || (bits & 7) != 0 || (bits >> 3) * r.height() != len)
+	{
+		return false;
+	}
+
+	GSOffset* o = m_mem.GetOffset(m_env.BITBLTBUF.DBP, m_env.BITBLTBUF.DBW, m_env.BITBLTBUF.DPSM);
+
+	shared_ptr<GSRasterizerData> data(new GSWriteImageData(this, src, len, r));
+
+	data->dependency = GetLastUpdate();
+
+	m_write_offset = _InterlockedIncrement(&m_write_count) == 1 || m_write_offset == o ? o : NULL;
+
+	QueuePending();
+
+	m_rl->Queue(data);
+
+	m_perfmon.Put(GSPerfMon::SwizzleAsync, len);
+
+	return true;
+}
+
+int GSRendererSW::Freeze(GSFreezeData* fd, bool sizeonly)
+{
+	if(!sizeonly)
+	{
+		Flush();
+
+		Sync(9); // the workers may still be drawing the previous frame
+	}
+
+	return GSRendererT<GSVertexSW>::Freeze(fd, sizeonly);
+}
+
+int GSRendererSW::Defrost(const GSFreezeData* fd)
+{
+	Sync(9);
+
+	return GSRendererT<GSVertexSW>::Defrost(fd);
+}
+
 void GSRendererSW::UsePages(const vector<uint32>* pages, int type)
 {
 	if(type < 2)
@@ -444,6 +718,53 @@ void GSRendererSW::ReleasePages(const vector<uint32>* pages, int type)
 	}
 }
 
+bool GSRendererSW::UpdateTexture(GSTextureCacheSW::Texture* t, const GSVector4i& r)
+{
+	if(!m_prefetch || s_dump)
+	{
+		return t->Update(r);
+	}
+
+	vector<GSTextureCacheSW::Texture::Block> blocks;
+
+	if(!t->Update(r, &blocks))
+	{
+		return false;
+	}
+
+	// a few blocks are not worth the trip, and the draw would wait for them anyway
+
+	if(blocks.size() < 32)
+	{
+		if(!blocks.empty())
+		{
+			t->Read(&blocks[0], &blocks[0] + blocks.size());
+		}
+
+		return true;
+	}
+
+	shared_ptr<GSRasterizerData> data(new GSTextureUpdateData(this, t, blocks));
+
+	QueuePending(); // keeps the draw order, whatever waits for this must not get ahead of the ones before it
+
+	m_rl->Queue(data);
+
+	m_last_update = data;
+
+	return true;
+}
+
+shared_ptr<GSRasterizerData> GSRendererSW::GetLastUpdate()
+{
+	if(m_last_update && m_last_update->remaining <= 0)
+	{
+		m_last_update.reset();
+	}
+
+	return m_last_update;
+}
+
 #include "GSTextureSW.h"
 
 bool GSRendererSW::GetScanlineGlobalData(GSRasterizerData2* data2)
@@ -545,7 +866,7 @@ bool GSRendererSW::GetScanlineGlobalData(GSRasterizerData2* data2)
 			{
 				gd.sel.tlu = 1;
 
-				gd.clut = (uint32*)_aligned_malloc(sizeof(uint32) * 256, 32); // FIXME: might address uninitialized data of the texture (0xCD) that is not in 0-15 range for 4-bpp formats
+				gd.clut = (uint32*)m_pool.Alloc(sizeof(uint32) * 256); // FIXME: might address uninitialized data of the texture (0xCD) that is not in 0-15 range for 4-bpp formats
 
 				memcpy(gd.clut, (const uint32*)m_mem.m_clut, sizeof(uint32) * GSLocalMemory::m_psm[context->TEX0.PSM].pal);
 			}
@@ -570,7 +891,7 @@ bool GSRendererSW::GetScanlineGlobalData(GSRasterizerData2* data2)
 
 			GetTextureMinMax(r, context->TEX0, context->CLAMP, gd.sel.ltf);
 
-			if(!t->Update(r)) {ASSERT(0); return false;}
+			if(!UpdateTexture(t, r)) {ASSERT(0); return false;}
 
 			if(s_dump)// && m_context->TEX1.MXL > 0 && m_context->TEX1.MMIN >= 2 && m_context->TEX1.MMIN <= 5 && m_vt.m_lod.x > 0)
 			{
@@ -723,7 +1044,7 @@ bool GSRendererSW::GetScanlineGlobalData(GSRasterizerData2* data2)
 
 					GetTextureMinMax(r, MIP_TEX0, MIP_CLAMP, gd.sel.ltf);
 
-					if(!t->Update(r)) {ASSERT(0); return false;}
+					if(!UpdateTexture(t, r)) {ASSERT(0); return false;}
 
 					gd.tex[i] = t->m_buff;
 
@@ -926,7 +1247,7 @@ bool GSRendererSW::GetScanlineGlobalData(GSRasterizerData2* data2)
 		{
 			gd.sel.dthe = 1;
 
-			gd.dimx = (GSVector4i*)_aligned_malloc(sizeof(env.dimx), 32);
+			gd.dimx = (GSVector4i*)m_pool.Alloc(sizeof(env.dimx));
 
 			memcpy(gd.dimx, env.dimx, sizeof(env.dimx));
 		}
@@ -1005,119 +1326,134 @@ void GSRendererSW::VertexKick(bool skip)
 		dst.t.u32[3] = m_v.XYZ.Z;
 	}
 
-	int count = 0;
-
-	if(GSVertexSW* v = DrawingKick<prim>(skip, count))
+	if(prim == GS_TRIANGLELIST || prim == GS_TRIANGLESTRIP || prim == GS_TRIANGLEFAN)
 	{
-if(!m_dump)
-{
-		GSVector4 pmin, pmax;
+		// strips and fans share their vertices, only the indices are repeated
 
-		switch(prim)
+		if(m_vl.GetCount() < 3)
 		{
-		case GS_POINTLIST:
-			pmin = v[0].p;
-			pmax = v[0].p;
-			break;
-		case GS_LINELIST:
-		case GS_LINESTRIP:
-		case GS_SPRITE:
-			pmin = v[0].p.min(v[1].p);
-			pmax = v[0].p.max(v[1].p);
-			break;
-		case GS_TRIANGLELIST:
-		case GS_TRIANGLESTRIP:
-		case GS_TRIANGLEFAN:
-			pmin = v[0].p.min(v[1].p).min(v[2].p);
-			pmax = v[0].p.max(v[1].p).max(v[2].p);
-			break;
+			return;
 		}
 
-		GSVector4 scissor = context->scissor.ex;
+		const GSVertexSW* v[3];
+		int* tag[3];
 
-		GSVector4 test = (pmax < scissor) | (pmin > scissor.zwxy());
-
-		switch(prim)
+		for(int i = 0; i < 3; i++)
 		{
-		case GS_TRIANGLELIST:
-		case GS_TRIANGLESTRIP:
-		case GS_TRIANGLEFAN:
-		case GS_SPRITE:
-			test |= pmin.ceil() == pmax.ceil();
-			break;
+			v[i] = &m_vl.GetAt(i);
+			tag[i] = &m_vl.GetTag(i);
 		}
 
 		switch(prim)
 		{
-		case GS_TRIANGLELIST:
-		case GS_TRIANGLESTRIP:
-		case GS_TRIANGLEFAN:
-			// are in line or just two of them are the same (cross product == 0)
-			GSVector4 tmp = (v[1].p - v[0].p) * (v[2].p - v[0].p).yxwz();
-			test |= tmp == tmp.yxwz();
-			break;
+		case GS_TRIANGLELIST: m_vl.RemoveAll(); break;
+		case GS_TRIANGLESTRIP: m_vl.RemoveAt(0, 2); break;
+		case GS_TRIANGLEFAN: m_vl.RemoveAt(1, 1); break;
 		}
 
-		if(test.mask() & 3)
+		if(skip || !m_dump && IsCulled<prim>(v[0]->p, v[1]->p, v[2]->p))
 		{
 			return;
 		}
-}
-		switch(prim)
+
+		if(m_count == 0)
 		{
-		case GS_POINTLIST:
-			break;
-		case GS_LINELIST:
-		case GS_LINESTRIP:
-			if(PRIM->IIP == 0) {v[0].c = v[1].c;}
-			break;
-		case GS_TRIANGLELIST:
-		case GS_TRIANGLESTRIP:
-		case GS_TRIANGLEFAN:
-			if(PRIM->IIP == 0) {v[0].c = v[2].c; v[1].c = v[2].c;}
-			break;
-		case GS_SPRITE:
-			break;
+			// the slots may still point into the previous batch
+
+			m_vl.ClearTags();
+
+			m_index_count = 0;
+
+			ResetBounds();
 		}
 
-		if(m_count < 30 && m_count >= 3)
+		if(m_count >= m_maxcount)
 		{
-			GSVertexSW* v = &m_vertices[m_count - 3];
+			GrowVertexBuffer();
+		}
 
-			int tl = 0;
-			int br = 0;
+		if(m_index_count + 3 > m_index_maxcount)
+		{
+			GrowIndexBuffer();
+		}
 
-			bool isquad = false;
+		uint32* RESTRICT index = &m_index[m_index_count];
+
+		if(PRIM->IIP == 0)
+		{
+			// flat shading takes the color of the last vertex, a shared vertex may be the last of another triangle
 
-			switch(prim)
+			for(int i = 0; i < 3; i++)
 			{
-			case GS_TRIANGLESTRIP:
-			case GS_TRIANGLEFAN:
-			case GS_TRIANGLELIST:
-				isquad = GSVertexSW::IsQuad(v, tl, br);
-				break;
+				GSVertexSW& dst = m_vertices[m_count];
+
+				dst = *v[i];
+				dst.c = v[2]->c;
+
+				index[i] = m_count++;
 			}
+		}
+		else
+		{
+			for(int i = 0; i < 3; i++)
+			{
+				if(*tag[i] < 0)
+				{
+					m_vertices[m_count] = *v[i];
 
-			if(isquad)
+					*tag[i] = m_count++;
+				}
+
+				index[i] = *tag[i];
+			}
+		}
+
+		m_index_count += 3;
+
+		AddBounds<prim, tme, fst>(m_vertices[index[0]], m_vertices[index[1]], m_vertices[index[2]]);
+
+		if(m_index_count >= 6 && m_index_count < 33)
+		{
+			GSVertexSW q[6];
+
+			for(int i = 0; i < 6; i++)
 			{
-				m_count -= 3;
+				q[i] = m_vertices[m_index[m_index_count - 6 + i]];
+			}
 
-				if(m_count > 0)
+			int tl = 0;
+			int br = 0;
+
+			if(GSVertexSW::IsQuad(q, tl, br))
+			{
+				m_index_count -= 6;
+
+				if(m_index_count > 0)
 				{
-					tl += m_count;
-					br += m_count;
+					// the vertices of the last two triangles stay unreferenced in the batch
+
+					ResetBounds();
+
+					for(int i = 0; i < m_index_count; i += 3)
+					{
+						AddBounds<prim, tme, fst>(m_vertices[m_index[i + 0]], m_vertices[m_index[i + 1]], m_vertices[m_index[i + 2]]);
+					}
 
 					Flush();
 				}
 
-				if(tl != 0) m_vertices[0] = m_vertices[tl];
-				if(br != 1) m_vertices[1] = m_vertices[br];
+				m_vertices[0] = q[tl];
+				m_vertices[1] = q[br];
 
 				m_vertices[0].t.u32[3] = m_v.XYZ.Z;
 				m_vertices[1].t.u32[3] = m_v.XYZ.Z;
 
 				m_count = 2;
 
+				ResetBounds();
+
+				AddBounds<GS_SPRITE, tme, fst>(m_vertices[0], m_vertices[1], m_vertices[1]);
+
 				uint32 tmp = PRIM->PRIM;
 				PRIM->PRIM = GS_SPRITE;
 
@@ -1126,17 +1462,187 @@ if(!m_dump)
 				PRIM->PRIM = tmp;
 
 				m_perfmon.Put(GSPerfMon::Quad, 1);
-
-				return;
 			}
 		}
 
+		return;
+	}
+
+	int count = 0;
+
+	if(GSVertexSW* v = DrawingKick<prim>(skip, count))
+	{
+		if(!m_dump && IsCulled<prim>(v[0].p, v[count - 1].p, v[count - 1].p))
+		{
+			return;
+		}
+
+		switch(prim)
+		{
+		case GS_POINTLIST:
+			break;
+		case GS_LINELIST:
+		case GS_LINESTRIP:
+			if(PRIM->IIP == 0) {v[0].c = v[1].c;}
+			break;
+		case GS_SPRITE:
+			break;
+		}
+
+		if(m_count == 0)
+		{
+			ResetBounds();
+		}
+
+		AddBounds<prim, tme, fst>(v[0], v[count - 1], v[count - 1]);
+
 		m_count += count;
 
 		// Flush();
 	}
 }
 
+template<uint32 prim>
+bool GSRendererSW::IsCulled(const GSVector4& p0, const GSVector4& p1, const GSVector4& p2)
+{
+	GSVector4 pmin, pmax;
+
+	switch(prim)
+	{
+	case GS_POINTLIST:
+		pmin = p0;
+		pmax = p0;
+		break;
+	case GS_LINELIST:
+	case GS_LINESTRIP:
+	case GS_SPRITE:
+		pmin = p0.min(p1);
+		pmax = p0.max(p1);
+		break;
+	case GS_TRIANGLELIST:
+	case GS_TRIANGLESTRIP:
+	case GS_TRIANGLEFAN:
+		pmin = p0.min(p1).min(p2);
+		pmax = p0.max(p1).max(p2);
+		break;
+	}
+
+	GSVector4 scissor = m_context->scissor.ex;
+
+	GSVector4 test = (pmax < scissor) | (pmin > scissor.zwxy());
+
+	switch(prim)
+	{
+	case GS_TRIANGLELIST:
+	case GS_TRIANGLESTRIP:
+	case GS_TRIANGLEFAN:
+	case GS_SPRITE:
+		test |= pmin.ceil() == pmax.ceil();
+		break;
+	}
+
+	switch(prim)
+	{
+	case GS_TRIANGLELIST:
+	case GS_TRIANGLESTRIP:
+	case GS_TRIANGLEFAN:
+		// are in line or just two of them are the same (cross product == 0)
+		GSVector4 tmp = (p1 - p0) * (p2 - p0).yxwz();
+		test |= tmp == tmp.yxwz();
+		break;
+	}
+
+	return (test.mask() & 3) != 0;
+}
+
+template<uint32 prim, uint32 tme, uint32 fst>
+void GSRendererSW::AddBounds(const GSVertexSW& v0, const GSVertexSW& v1, const GSVertexSW& v2)
+{
+	// the same as what the vertex trace would collect from the batch, while the vertices are still in the cache
+
+	const GSVertexSW* v[3] = {&v0, &v1, &v2};
+
+	int n = 3;
+
+	switch(prim)
+	{
+	case GS_POINTLIST: n = 1; break;
+	case GS_LINELIST: n = 2; break;
+	case GS_LINESTRIP: n = 2; break;
+	case GS_SPRITE: n = 2; break;
+	}
+
+	GSVector4 q;
+
+	if(tme && !fst && prim == GS_SPRITE)
+	{
+		q = v1.t.zzzz();
+	}
+
+	for(int i = 0; i < n; i++)
+	{
+		if(PRIM->IIP || i == n - 1)
+		{
+			m_bounds[0].c = m_bounds[0].c.min(v[i]->c);
+			m_bounds[1].c = m_bounds[1].c.max(v[i]->c);
+		}
+
+		m_bounds[0].p = m_bounds[0].p.min(v[i]->p);
+		m_bounds[1].p = m_bounds[1].p.max(v[i]->p);
+
+		if(tme)
+		{
+			GSVector4 t = v[i]->t;
+
+			if(!fst)
+			{
+				if(prim != GS_SPRITE)
+				{
+					q = t.zzzz();
+				}
+
+				t = (t / q).xyzw(q);
+			}
+
+			m_bounds[0].t = m_bounds[0].t.min(t);
+			m_bounds[1].t = m_bounds[1].t.max(t);
+		}
+	}
+}
+
+void GSRendererSW::ResetBounds()
+{
+	GSVector4 vmin(FLT_MAX);
+	GSVector4 vmax(-FLT_MAX);
+
+	m_bounds[0].p = vmin;
+	m_bounds[0].t = vmin;
+	m_bounds[0].c = vmin;
+	m_bounds[1].p = vmax;
+	m_bounds[1].t = vmax;
+	m_bounds[1].c = vmax;
+}
+
+void GSRendererSW::UpdateVertexTrace()
+{
+	m_vt.Update(m_bounds[0], m_bounds[1], GSUtil::GetPrimClass(PRIM->PRIM));
+}
+
+void GSRendererSW::GrowIndexBuffer()
+{
+	int maxcount = std::max<int>(m_index_maxcount * 3 / 2, 30000);
+	uint32* index = (uint32*)_aligned_malloc(sizeof(uint32) * maxcount, 16);
+
+	if(m_index != NULL)
+	{
+		memcpy(index, m_index, sizeof(uint32) * m_index_count);
+		_aligned_free(m_index);
+	}
+
+	m_index = index;
+	m_index_maxcount = maxcount;
+}
+
 // GSRendererSW::GSRasterizerData2
 
 GSRendererSW::GSRasterizerData2::GSRasterizerData2(GSRendererSW* parent)
@@ -1147,9 +1653,9 @@ GSRendererSW::GSRasterizerData2::GSRasterizerData2(GSRendererSW* parent)
 {
 	memset(m_tex_pages, 0, sizeof(m_tex_pages));
 
-	GSScanlineGlobalData* gd = (GSScanlineGlobalData*)_aligned_malloc(sizeof(GSScanlineGlobalData), 32);
+	GSScanlineGlobalData* gd = (GSScanlineGlobalData*)parent->m_pool.Alloc(sizeof(GSScanlineGlobalData));
 
-	gd->sel.key = 0;
+	memset(gd, 0, sizeof(*gd)); // Merge compares the whole thing
 
 	gd->clut = NULL;
 	gd->dimx = NULL;
@@ -1184,10 +1690,15 @@ GSRendererSW::GSRasterizerData2::~GSRasterizerData2()
 
 	GSScanlineGlobalData* gd = (GSScanlineGlobalData*)param;
 
-	if(gd->clut) _aligned_free(gd->clut);
-	if(gd->dimx) _aligned_free(gd->dimx);
+	if(gd->clut) m_parent->m_pool.Free(gd->clut);
+	if(gd->dimx) m_parent->m_pool.Free(gd->dimx);
+
+	m_parent->m_pool.Free(gd);
 
-	_aligned_free(gd);
+	// not for the base class to free
+
+	if(vertices != NULL) {m_parent->m_pool.Free(vertices); vertices = NULL;}
+	if(index != NULL) {m_parent->m_pool.Free(index); index = NULL;}
 
 	m_parent->m_perfmon.Put(GSPerfMon::Fillrate, pixels);
 }
@@ -1214,6 +1725,95 @@ void GSRendererSW::GSRasterizerData2::UseTargetPages(const vector<uint32>* fb_pa
 	m_using_pages = true;
 }
 
+bool GSRendererSW::GSRasterizerData2::Merge(const shared_ptr<GSRasterizerData>& data, int pal)
+{
+	if(data->primclass != primclass || data->frame != frame || !data->scissor.eq(scissor))
+	{
+		return false;
+	}
+
+	if(count + data->count > 1024)
+	{
+		return false;
+	}
+
+	const GSScanlineGlobalData* a = (const GSScanlineGlobalData*)param;
+	const GSScanlineGlobalData* b = (const GSScanlineGlobalData*)data->param;
+
+	// everything but the clut and dimx copies, those are compared by value
+
+	if(a->sel.key != b->sel.key
+	|| memcmp(&a->vm, &b->vm, offsetof(GSScanlineGlobalData, clut) - offsetof(GSScanlineGlobalData, vm)) != 0
+	|| memcmp(&a->fbr, &b->fbr, sizeof(GSScanlineGlobalData) - offsetof(GSScanlineGlobalData, fbr)) != 0)
+	{
+		return false;
+	}
+
+	if((a->clut == NULL) != (b->clut == NULL) || a->clut != NULL && memcmp(a->clut, b->clut, sizeof(uint32) * pal) != 0)
+	{
+		return false;
+	}
+
+	if((a->dimx == NULL) != (b->dimx == NULL) || a->dimx != NULL && memcmp(a->dimx, b->dimx, sizeof(GSVector4i) * 8) != 0)
+	{
+		return false;
+	}
+
+	GSVertexSW* v = (GSVertexSW*)m_parent->m_pool.Alloc(sizeof(GSVertexSW) * (count + data->count));
+
+	memcpy(v, vertices, sizeof(GSVertexSW) * count);
+	memcpy(v + count, data->vertices, sizeof(GSVertexSW) * data->count);
+
+	m_parent->m_pool.Free(vertices);
+
+	vertices = v;
+
+	if(index != NULL)
+	{
+		uint32* RESTRICT i = (uint32*)m_parent->m_pool.Alloc(sizeof(uint32) * (index_count + data->index_count));
+
+		memcpy(i, index, sizeof(uint32) * index_count);
+
+		for(int j = 0; j < data->index_count; j++)
+		{
+			i[index_count + j] = data->index[j] + count;
+		}
+
+		m_parent->m_pool.Free(index);
+
+		index = i;
+		index_count += data->index_count;
+	}
+
+	count += data->count;
+
+	bbox = bbox.runion(data->bbox);
+
+	if(data->dependency)
+	{
+		dependency = data->dependency; // queued after ours, when it is done ours is too
+	}
+
+	// the vertices are copied, but its pages must stay in use
+
+	m_parent->m_pool.Free(data->vertices);
+
+	data->vertices = NULL;
+	data->count = 0;
+
+	if(data->index != NULL)
+	{
+		m_parent->m_pool.Free(data->index);
+
+		data->index = NULL;
+		data->index_count = 0;
+	}
+
+	m_merged.push_back(data);
+
+	return true;
+}
+
 void GSRendererSW::GSRasterizerData2::UseSourcePages(GSTextureCacheSW::Texture* t, int level)
 {
 	ASSERT(m_tex_pages[level] == NULL);
@@ -1224,3 +1824,207 @@ void GSRendererSW::GSRasterizerData2::UseSourcePages(GSTextureCacheSW::Texture*
 
 	m_parent->UsePages(pages, 2);
 }
+
+// GSTextureUpdateData
+
+GSRendererSW::GSTextureUpdateData::GSTextureUpdateData(GSRendererSW* parent, GSTextureCacheSW::Texture* t, vector<GSTextureCacheSW::Texture::Block>& blocks)
+	: m_parent(parent)
+	, m_texture(t)
+{
+	m_blocks.swap(blocks);
+
+	const GSLocalMemory::psm_t& psm = GSLocalMemory::m_psm[t->m_TEX0.PSM];
+
+	scissor = GSVector4i(0, m_blocks.front().y, 1, m_blocks.back().y + psm.bs.y);
+	bbox = scissor;
+	transfer = true;
+	barrier = true;
+	frame = parent->m_perfmon.GetFrame();
+
+	// the source pages count as a texture in use until it is done, transfers into them sync
+
+	parent->UsePages(t->m_pages.n, 2);
+
+	int bytes = (psm.bs.x * psm.bs.y << (psm.pal == 0 ? 2 : 0)) * (int)m_blocks.size();
+
+	parent->m_perfmon.Put(GSPerfMon::UnswizzleAsync, bytes);
+}
+
+GSRendererSW::GSTextureUpdateData::~GSTextureUpdateData()
+{
+	m_parent->ReleasePages(m_texture->m_pages.n, 2);
+
+	m_parent->m_perfmon.Put(GSPerfMon::UnswizzleTicks, ticks);
+}
+
+void GSRendererSW::GSTextureUpdateData::Transfer(int top, int bottom)
+{
+	uint64 start = __rdtsc();
+
+	// the blocks are in row order, this worker owns [top, bottom)
+
+	const GSTextureCacheSW::Texture::Block* b = &m_blocks[0];
+	const GSTextureCacheSW::Texture::Block* e = b + m_blocks.size();
+
+	while(b < e && b->y < top) b++;
+
+	const GSTextureCacheSW::Texture::Block* c = b;
+
+	while(c < e && c->y < bottom) c++;
+
+	m_texture->Read(b, c);
+
+	_InterlockedExchangeAdd(&ticks, (long)(__rdtsc() - start));
+}
+
+// GSBufferPool
+
+GSRendererSW::GSBufferPool::GSBufferPool(GSPerfMon* perfmon)
+	: m_size(0)
+	, m_perfmon(perfmon)
+{
+}
+
+GSRendererSW::GSBufferPool::~GSBufferPool()
+{
+	for(int i = 0; i < CLASSES; i++)
+	{
+		for(vector<void*>::iterator j = m_free[i].begin(); j != m_free[i].end(); j++)
+		{
+			_aligned_free(*j);
+		}
+	}
+}
+
+void* GSRendererSW::GSBufferPool::Alloc(size_t size)
+{
+	uint64 start = __rdtsc();
+
+	// the size class is stored in front of the buffer, 32 bytes to keep the alignment
+
+	int i = 0;
+
+	while(i < CLASSES && (size_t)(256 << i) < size) i++;
+
+	uint8* p = NULL;
+
+	if(i < CLASSES)
+	{
+		m_lock.Lock();
+
+		if(!m_free[i].empty())
+		{
+			p = (uint8*)m_free[i].back();
+
+			m_free[i].pop_back();
+
+			m_size -= 256 << i;
+		}
+
+		m_lock.Unlock();
+
+		if(p != NULL)
+		{
+			m_perfmon->Put(GSPerfMon::AllocPooled, 1);
+		}
+		else
+		{
+			p = (uint8*)_aligned_malloc((256 << i) + 32, 32);
+		}
+	}
+	else
+	{
+		p = (uint8*)_aligned_malloc(size + 32, 32);
+	}
+
+	*(int*)p = i;
+
+	m_perfmon->Put(GSPerfMon::Alloc, 1);
+	m_perfmon->Put(GSPerfMon::AllocTicks, (double)(__rdtsc() - start));
+
+	return p + 32;
+}
+
+void GSRendererSW::GSBufferPool::Free(void* p)
+{
+	if(p == NULL) return;
+
+	uint8* b = (uint8*)p - 32;
+
+	int i = *(int*)b;
+
+	if(i < CLASSES)
+	{
+		m_lock.Lock();
+
+		if(m_size + (256 << i) <= MAX_SIZE)
+		{
+			m_free[i].push_back(b);
+
+			m_size += 256 << i;
+
+			b = NULL;
+		}
+
+		m_lock.Unlock();
+	}
+
+	if(b != NULL)
+	{
+		_aligned_free(b);
+	}
+}
+
+// GSWriteImageData
+
+GSRendererSW::GSWriteImageData::GSWriteImageData(GSRendererSW* parent, const uint8* src, int len, const GSVector4i& r)
+	: m_parent(parent)
+	, m_BITBLTBUF(parent->m_env.BITBLTBUF)
+	, m_TRXPOS(parent->m_env.TRXPOS)
+	, m_TRXREG(parent->m_env.TRXREG)
+{
+	scissor = r;
+	bbox = r;
+	transfer = true;
+	frame = parent->m_perfmon.GetFrame();
+
+	m_pitch = len / r.height();
+
+	m_buff = (uint8*)parent->m_pool.Alloc(len);
+
+	memcpy(m_buff, src, len);
+
+	// the destination counts as a frame buffer until the transfer is done, so texture fetches,
+	// readbacks and other transfers touching these pages sync with it
+
+	m_pages = parent->m_mem.GetOffset(m_BITBLTBUF.DBP, m_BITBLTBUF.DBW, m_BITBLTBUF.DPSM)->GetPages(r);
+
+	parent->UsePages(m_pages, 0);
+}
+
+GSRendererSW::GSWriteImageData::~GSWriteImageData()
+{
+	m_parent->ReleasePages(m_pages, 0);
+
+	delete m_pages;
+
+	m_parent->m_pool.Free(m_buff);
+
+	_InterlockedDecrement(&m_parent->m_write_count);
+}
+
+void GSRendererSW::GSWriteImageData::Transfer(int top, int bottom)
+{
+	// WriteImage takes its registers by reference, every worker gets its own copy
+
+	GIFRegBITBLTBUF BITBLTBUF = m_BITBLTBUF;
+	GIFRegTRXPOS TRXPOS = m_TRXPOS;
+	GIFRegTRXREG TRXREG = m_TRXREG;
+
+	int x = bbox.left;
+	int y = top;
+
+	GSLocalMemory::writeImage wi = GSLocalMemory::m_psm[BITBLTBUF.DPSM].wi;
+
+	(m_parent->m_mem.*wi)(x, y, &m_buff[(top - bbox.top) * m_pitch], (bottom - top) * m_pitch, BITBLTBUF, TRXPOS, TRXREG);
+}
@@ -27,6 +27,26 @@
 
 class GSRendererSW : public GSRendererT<GSVertexSW>
 {
+	class GSBufferPool
+	{
+		// the draws are allocated here and freed by whichever worker finishes them last, 
+		// the buffers are kept for the next draws instead of going back to the heap
+
+		enum {CLASSES = 16, MAX_SIZE = 32 * 1024 * 1024};
+
+		GSCritSec m_lock;
+		vector<void*> m_free[CLASSES]; // 256 << i bytes
+		size_t m_size;
+		GSPerfMon* m_perfmon;
+
+	public:
+		GSBufferPool(GSPerfMon* perfmon);
+		virtual ~GSBufferPool();
+
+		void* Alloc(size_t size); // from the gs thread only
+		void Free(void* p);
+	};
+
 	class GSRasterizerData2 : public GSRasterizerData
 	{
 		GSRendererSW* m_parent;
@@ -34,6 +54,7 @@ class GSRendererSW : public GSRendererT<GSVertexSW>
 		const vector<uint32>* m_zb_pages;
 		const vector<uint32>* m_tex_pages[7];
 		bool m_using_pages;
+		vector<shared_ptr<GSRasterizerData> > m_merged; // keep their pages in use until this one is done
 
 	public:
 		GSRasterizerData2(GSRendererSW* parent);
@@ -41,6 +62,37 @@ class GSRendererSW : public GSRendererT<GSVertexSW>
 
 		void UseTargetPages(const vector<uint32>* fb_pages, const vector<uint32>* zb_pages);
 		void UseSourcePages(GSTextureCacheSW::Texture* t, int level);
+		bool Merge(const shared_ptr<GSRasterizerData>& data, int pal);
+	};
+
+	class GSWriteImageData : public GSRasterizerData
+	{
+		GSRendererSW* m_parent;
+		GIFRegBITBLTBUF m_BITBLTBUF;
+		GIFRegTRXPOS m_TRXPOS;
+		GIFRegTRXREG m_TRXREG;
+		uint8* m_buff;
+		int m_pitch;
+		const vector<uint32>* m_pages;
+
+	public:
+		GSWriteImageData(GSRendererSW* parent, const uint8* src, int len, const GSVector4i& r);
+		virtual ~GSWriteImageData();
+
+		void Transfer(int top, int bottom);
+	};
+
+	class GSTextureUpdateData : public GSRasterizerData
+	{
+		GSRendererSW* m_parent;
+		GSTextureCacheSW::Texture* m_texture;
+		vector<GSTextureCacheSW::Texture::Block> m_blocks;
+
+	public:
+		GSTextureUpdateData(GSRendererSW* parent, GSTextureCacheSW::Texture* t, vector<GSTextureCacheSW::Texture::Block>& blocks);
+		virtual ~GSTextureUpdateData();
+
+		void Transfer(int top, int bottom);
 	};
 
 protected:
@@ -52,26 +104,52 @@ protected:
 	GSPixelOffset4* m_fzb;
 	uint32 m_fzb_pages[512]; // uint16 frame/zbuf pages interleaved
 	uint16 m_tex_pages[512];
+	volatile long m_write_count; // image transfers still queued to the workers
+	GSOffset* m_write_offset; // their destination layout, NULL if they differ
+	uint32* m_index; // triangles index m_vertices, strips and fans reuse the previous vertices
+	int m_index_count;
+	int m_index_maxcount;
+	GSVertexSW m_bounds[2]; // min/max of the batch, collected by VertexKick instead of GSVertexTrace
+	shared_ptr<GSRasterizerData> m_pending; // a small draw held back, the next one may be appended to it
+	GSTrace m_trace;
+	GSBufferPool m_pool;
+	bool m_prefetch; // texture blocks are read by the workers
+	shared_ptr<GSRasterizerData> m_last_update; // everything queued after it has to wait for it, the texture pages it reads may be written
 
 	void Reset();
 	void VSync(int field);
 	void ResetDevice();
 	GSTexture* GetOutput(int i);
 
+	void UpdateVertexTrace();
 	void Draw();
+	void QueuePending();
 	void Sync(int reason);
 	void InvalidateVideoMem(const GIFRegBITBLTBUF& BITBLTBUF, const GSVector4i& r);
 	void InvalidateLocalMem(const GIFRegBITBLTBUF& BITBLTBUF, const GSVector4i& r, bool clut = false);
+	bool WriteImageAsync(const uint8* src, int len, const GSVector4i& r);
+	int Freeze(GSFreezeData* fd, bool sizeonly);
+	int Defrost(const GSFreezeData* fd);
 
 	void UsePages(const vector<uint32>* pages, int type);
 	void ReleasePages(const vector<uint32>* pages, int type);
 
 	bool GetScanlineGlobalData(GSRasterizerData2* data2);
+	bool UpdateTexture(GSTextureCacheSW::Texture* t, const GSVector4i& r);
+	shared_ptr<GSRasterizerData> GetLastUpdate();
+
+	void GrowIndexBuffer();
+	void ResetBounds();
+
+	template<uint32 prim> bool IsCulled(const GSVector4& p0, const GSVector4& p1, const GSVector4& p2);
+	template<uint32 prim, uint32 tme, uint32 fst> void AddBounds(const GSVertexSW& v0, const GSVertexSW& v1, const GSVertexSW& v2);
 
 public:
 	GSRendererSW(int threads);
 	virtual ~GSRendererSW();
 
+	void VSyncHash(uint64& vm, uint64& out);
+
 	template<uint32 prim, uint32 tme, uint32 fst>
 	void VertexKick(bool skip);
 };
@@ -37,6 +37,8 @@ GSState::GSState()
 	, m_options(0)
 	, m_frameskip(0)
 {
+	m_mem.m_clut.SetPerfMon(&m_perfmon);
+
 	m_sssize = 0;
 
 	m_sssize += sizeof(m_version);
@@ -590,6 +592,13 @@ void GSState::ApplyTEX0(int i, GIFRegTEX0& TEX0)
 {
 	// even if TEX0 did not change, a new palette may have been uploaded and will overwrite the currently queued for drawing
 
+	if(TEX0.CLD != 0)
+	{
+		// the queued primitives are only flushed after the test, they may render the palette
+
+		InvalidateClut(GSVector4i(m_context->scissor.in));
+	}
+
 	bool wt = m_mem.m_clut.WriteTest(TEX0, m_env.TEXCLUT);
 
 	// clut loading already covered with WriteTest, for drawing only have to check CPSM and CSA (MGS3 intro skybox would be drawn piece by piece without this)
@@ -1129,6 +1138,19 @@ void GSState::Flush()
 	FlushPrim();
 }
 
+void GSState::InvalidateClut(const GSVector4i& r)
+{
+	if(m_context->FRAME.FBMSK != 0xffffffff)
+	{
+		m_mem.m_clut.Invalidate(m_context->FRAME.Block(), m_context->FRAME.FBW, m_context->FRAME.PSM, r);
+	}
+
+	if(m_context->ZBUF.ZMSK == 0)
+	{
+		m_mem.m_clut.Invalidate(m_context->ZBUF.Block(), m_context->FRAME.FBW, m_context->ZBUF.PSM, r);
+	}
+}
+
 void GSState::FlushWrite()
 {
 	int len = m_tr.end - m_tr.start;
@@ -1146,9 +1168,18 @@ void GSState::FlushWrite()
 	
 	//int y = m_tr.y;
 
-	GSLocalMemory::writeImage wi = GSLocalMemory::m_psm[m_env.BITBLTBUF.DPSM].wi;
+	if(m_tr.start == 0 && len == m_tr.total && m_tr.x == r.left && m_tr.y == r.top && WriteImageAsync(m_tr.buff, len, r))
+	{
+		// the whole transfer was buffered and handed over in one piece
 
-	(m_mem.*wi)(m_tr.x, m_tr.y, &m_tr.buff[m_tr.start], len, m_env.BITBLTBUF, m_env.TRXPOS, m_env.TRXREG);
+		m_tr.y = r.bottom;
+	}
+	else
+	{
+		GSLocalMemory::writeImage wi = GSLocalMemory::m_psm[m_env.BITBLTBUF.DPSM].wi;
+
+		(m_mem.*wi)(m_tr.x, m_tr.y, &m_tr.buff[m_tr.start], len, m_env.BITBLTBUF, m_env.TRXPOS, m_env.TRXREG);
+	}
 
 	m_tr.start += len;
 
@@ -1210,7 +1241,14 @@ void GSState::Write(const uint8* mem, int len)
 
 		InvalidateVideoMem(m_env.BITBLTBUF, r);
 
-		(m_mem.*psm.wi)(m_tr.x, m_tr.y, mem, m_tr.total, m_env.BITBLTBUF, m_env.TRXPOS, m_env.TRXREG);
+		if(m_tr.x == r.left && m_tr.y == r.top && WriteImageAsync(mem, m_tr.total, r))
+		{
+			m_tr.y = r.bottom;
+		}
+		else
+		{
+			(m_mem.*psm.wi)(m_tr.x, m_tr.y, mem, m_tr.total, m_env.BITBLTBUF, m_env.TRXPOS, m_env.TRXREG);
+		}
 
 		m_tr.start = m_tr.end = m_tr.total;
 
@@ -1230,7 +1268,14 @@ void GSState::Write(const uint8* mem, int len)
 		}
 	}
 
-	m_mem.m_clut.Invalidate();
+	GSVector4i r;
+
+	r.left = m_env.TRXPOS.DSAX;
+	r.top = m_env.TRXPOS.DSAY;
+	r.right = r.left + m_env.TRXREG.RRW;
+	r.bottom = r.top + m_env.TRXREG.RRH;
+
+	m_mem.m_clut.Invalidate(m_env.BITBLTBUF.DBP, m_env.BITBLTBUF.DBW, m_env.BITBLTBUF.DPSM, r);
 }
 
 void GSState::Read(uint8* mem, int len)
@@ -1272,6 +1317,8 @@ void GSState::Move()
 	InvalidateLocalMem(m_env.BITBLTBUF, GSVector4i(sx, sy, sx + w, sy + h));
 	InvalidateVideoMem(m_env.BITBLTBUF, GSVector4i(dx, dy, dx + w, dy + h));
 
+	m_mem.m_clut.Invalidate(m_env.BITBLTBUF.DBP, m_env.BITBLTBUF.DBW, m_env.BITBLTBUF.DPSM, GSVector4i(dx, dy, dx + w, dy + h));
+
 	int xinc = 1;
 	int yinc = 1;
 
@@ -1839,6 +1886,8 @@ int GSState::Defrost(const GSFreezeData* fd)
 	ReadState(&m_tr.y, data);
 	ReadState(m_mem.m_vm8, data, m_mem.m_vmsize);
 
+	m_mem.m_clut.Invalidate();
+
 	m_tr.total = 0; // TODO: restore transfer state
 
 	for(size_t i = 0; i < countof(m_path); i++)
@@ -130,6 +130,7 @@ class GSState : public GSAlignedClass<32>
 
 protected:
 	bool IsBadFrame(int& skip, int UserHacks_SkipDraw);
+	void InvalidateClut(const GSVector4i& r);
 
 	typedef void (GSState::*VertexKickPtr)(bool skip);
 
@@ -209,6 +210,7 @@ public:
 	virtual void ResetPrim() = 0;
 	virtual void InvalidateVideoMem(const GIFRegBITBLTBUF& BITBLTBUF, const GSVector4i& r) {}
 	virtual void InvalidateLocalMem(const GIFRegBITBLTBUF& BITBLTBUF, const GSVector4i& r, bool clut = false) {}
+	virtual bool WriteImageAsync(const uint8* src, int len, const GSVector4i& r) {return false;}
 
 	void Move();
 	void Write(const uint8* mem, int len);
@@ -218,8 +220,8 @@ public:
 	void WriteCSR(uint32 csr) {m_regs->CSR.u32[1] = csr;}
 	void ReadFIFO(uint8* mem, int size);
 	template<int index> void Transfer(const uint8* mem, uint32 size);
-	int Freeze(GSFreezeData* fd, bool sizeonly);
-	int Defrost(const GSFreezeData* fd);
+	virtual int Freeze(GSFreezeData* fd, bool sizeonly);
+	virtual int Defrost(const GSFreezeData* fd);
 	void GetLastTag(uint32* tag) {*tag = m_path3hack; m_path3hack = 0;}
 	virtual void SetGameCRC(uint32 crc, int options);
 	void SetFrameSkip(int skip);
@@ -25,6 +25,8 @@
 GSTextureCacheSW::GSTextureCacheSW(GSState* state)
 	: m_state(state)
 {
+	m_lookups.hit = 0;
+	m_lookups.miss = 0;
 }
 
 GSTextureCacheSW::~GSTextureCacheSW()
@@ -65,6 +67,8 @@ GSTextureCacheSW::Texture* GSTextureCacheSW::Lookup(const GIFRegTEX0& TEX0, cons
 
 		t->m_age = 0;
 
+		m_lookups.hit++;
+
 		break;
 	}
 
@@ -74,6 +78,8 @@ GSTextureCacheSW::Texture* GSTextureCacheSW::Lookup(const GIFRegTEX0& TEX0, cons
 
 		m_textures.insert(t);
 
+		m_lookups.miss++;
+
 		for(vector<uint32>::const_iterator i = t->m_pages.n->begin(); i != t->m_pages.n->end(); i++)
 		{
 			m_map[*i].push_front(t);
@@ -150,8 +156,10 @@ void GSTextureCacheSW::RemoveAt(Texture* t)
 	delete t;
 }
 
-void GSTextureCacheSW::IncAge()
+void GSTextureCacheSW::IncAge(const uint16* busy)
 {
+	// busy: page use counts of the draws still queued, a texture can only be in use if all of its pages are
+
 	for(hash_set<Texture*>::iterator i = m_textures.begin(); i != m_textures.end(); )
 	{
 		hash_set<Texture*>::iterator j = i++;
@@ -160,6 +168,21 @@ void GSTextureCacheSW::IncAge()
 
 		if(++t->m_age > 30)
 		{
+			if(busy != NULL)
+			{
+				bool used = true;
+
+				for(vector<uint32>::const_iterator k = t->m_pages.n->begin(); k != t->m_pages.n->end() && used; k++)
+				{
+					used = busy[*k] != 0;
+				}
+
+				if(used)
+				{
+					continue;
+				}
+			}
+
 			RemoveAt(t);
 		}
 	}
@@ -210,8 +233,10 @@ GSTextureCacheSW::Texture::~Texture()
 	}
 }
 
-bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect)
+bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect, vector<Block>* deferred)
 {
+	// deferred: the blocks are only marked valid and collected in row order, Read has to be called with them before sampling
+
 	if(m_complete)
 	{
 		return true;
@@ -291,7 +316,16 @@ bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect)
 					{
 						m_valid[row] |= col;
 
-						(mem.*rtxbP)(block, &dst[x << shift], pitch, m_TEXA);
+						if(deferred == NULL)
+						{
+							(mem.*rtxbP)(block, &dst[x << shift], pitch, m_TEXA);
+						}
+						else
+						{
+							Block b = {block, y, &dst[x << shift]};
+
+							deferred->push_back(b);
+						}
 
 						blocks++;
 					}
@@ -318,7 +352,16 @@ bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect)
 					{
 						m_valid[row] |= col;
 
-						(mem.*rtxbP)(block, &dst[x << shift], pitch, m_TEXA);
+						if(deferred == NULL)
+						{
+							(mem.*rtxbP)(block, &dst[x << shift], pitch, m_TEXA);
+						}
+						else
+						{
+							Block b = {block, y, &dst[x << shift]};
+
+							deferred->push_back(b);
+						}
 
 						blocks++;
 					}
@@ -335,6 +378,20 @@ bool GSTextureCacheSW::Texture::Update(const GSVector4i& rect)
 	return true;
 }
 
+void GSTextureCacheSW::Texture::Read(const Block* RESTRICT b, const Block* RESTRICT e) const
+{
+	GSLocalMemory& mem = m_state->m_mem;
+
+	GSLocalMemory::readTextureBlock rtxbP = GSLocalMemory::m_psm[m_TEX0.PSM].rtxbP;
+
+	uint32 pitch = (1 << m_tw) << (GSLocalMemory::m_psm[m_TEX0.PSM].pal == 0 ? 2 : 0);
+
+	for(; b < e; b++)
+	{
+		(mem.*rtxbP)(b->block, b->dst, pitch, m_TEXA);
+	}
+}
+
 #include "GSTextureSW.h"
 
 bool GSTextureCacheSW::Texture::Save(const string& fn, bool dds) const
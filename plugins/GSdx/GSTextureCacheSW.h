@@ -29,6 +29,8 @@ public:
 	class Texture
 	{
 	public:
+		struct Block {uint32 block; int y; uint8* dst;};
+
 		GSState* m_state;
 		GSOffset* m_offset;
 		GIFRegTEX0 m_TEX0;
@@ -49,7 +51,8 @@ public:
 		Texture(GSState* state, uint32 tw0, const GIFRegTEX0& TEX0, const GIFRegTEXA& TEXA);
 		virtual ~Texture();
 
-		bool Update(const GSVector4i& r);
+		bool Update(const GSVector4i& r, vector<Block>* deferred = NULL);
+		void Read(const Block* RESTRICT b, const Block* RESTRICT e) const;
 		bool Save(const string& fn, bool dds = false) const;
 	};
 
@@ -59,6 +62,8 @@ protected:
 	list<Texture*> m_map[MAX_PAGES];
 
 public:
+	struct {int hit, miss;} m_lookups;
+
 	GSTextureCacheSW(GSState* state);
 	virtual ~GSTextureCacheSW();
 
@@ -68,5 +73,5 @@ public:
 
 	void RemoveAll();
 	void RemoveAt(Texture* t);
-	void IncAge();
+	void IncAge(const uint16* busy = NULL);
 };
@@ -0,0 +1,100 @@
+/*
+ *	Copyright (C) 2007-2009 Gabest
+ *	http://www.gabest.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GNU Make; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+
+#include "stdafx.h"
+#include "GSTrace.h"
+#include "GSUtil.h"
+
+GSTrace::GSTrace()
+	: m_fp(NULL)
+	, m_draws(NULL)
+	, m_count(0)
+	, m_maxcount(0)
+{
+}
+
+GSTrace::~GSTrace()
+{
+	Close();
+}
+
+void GSTrace::Open(const string& fn)
+{
+	Close();
+
+	m_fp = fopen(fn.c_str(), "wb");
+
+	if(m_fp)
+	{
+		uint32 header[3] = {GSTRACE_VERSION, sizeof(GSTraceDraw), GSTRACE_WORKERS};
+
+		fwrite("GSTR", 4, 1, m_fp);
+		fwrite(header, sizeof(header), 1, m_fp);
+
+		m_maxcount = 16384;
+		m_draws = (GSTraceDraw*)_aligned_malloc(sizeof(GSTraceDraw) * m_maxcount, 32);
+		m_count = 0;
+	}
+}
+
+void GSTrace::Close()
+{
+	if(m_fp) {fclose(m_fp); m_fp = NULL;}
+	if(m_draws) {_aligned_free(m_draws); m_draws = NULL;}
+
+	m_count = 0;
+	m_maxcount = 0;
+}
+
+GSTraceDraw* GSTrace::Add()
+{
+	if(m_fp == NULL || m_count >= m_maxcount)
+	{
+		return NULL;
+	}
+
+	GSTraceDraw* draw = &m_draws[m_count++];
+
+	memset(draw, 0, sizeof(*draw));
+
+	return draw;
+}
+
+void GSTrace::Flush(uint64 frame)
+{
+	// the workers must be done with the records, the caller syncs before this
+
+	if(m_fp)
+	{
+		uint32 count = m_count;
+		uint32 ms = GSUtil::GetMilliseconds();
+		uint64 tsc = __rdtsc();
+
+		fwrite(&count, 4, 1, m_fp);
+		fwrite(&ms, 4, 1, m_fp);
+		fwrite(&tsc, 8, 1, m_fp);
+		fwrite(&frame, 8, 1, m_fp);
+		fwrite(m_draws, sizeof(GSTraceDraw), m_count, m_fp);
+
+		m_count = 0;
+	}
+}
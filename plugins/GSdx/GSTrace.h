@@ -0,0 +1,82 @@
+/*
+ *	Copyright (C) 2007-2009 Gabest
+ *	http://www.gabest.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GNU Make; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+
+#pragma once
+
+#include "GS.h"
+
+/*
+
+Trace file format:
+- [id/4 "GSTR"] [version/4] [record size/4] [workers/4] [block] .. [block]
+
+Block, written at vsync
+- [count/4] [ms/4] [tsc/8] [frame/8] [record/record size] .. [record/record size]
+
+The tsc and ms pairs of the blocks give the tsc frequency to the reader.
+
+*/
+
+#define GSTRACE_VERSION 1
+#define GSTRACE_WORKERS 16
+
+enum
+{
+	GSTRACE_MERGED = 1, // the vertices went into the previous draw, its worker times cover this one too
+	GSTRACE_SOLIDRECT = 2,
+	GSTRACE_SYNCPOINT = 4,
+};
+
+struct GSTraceDraw
+{
+	uint64 sel;
+	uint64 tsc; // when it was queued
+	uint32 frame;
+	uint16 primclass;
+	uint16 flags;
+	uint32 count;
+	uint32 prims;
+	int16 bbox[4];
+	uint16 tex_hit;
+	uint16 tex_miss;
+	uint32 reserved;
+	struct {uint32 start, ticks, pixels, reserved;} worker[GSTRACE_WORKERS]; // start is relative to tsc, ticks is zero when the worker did not have any part of it
+};
+
+class GSTrace
+{
+	FILE* m_fp;
+	GSTraceDraw* m_draws;
+	int m_count;
+	int m_maxcount;
+
+public:
+	GSTrace();
+	virtual ~GSTrace();
+
+	void Open(const string& fn);
+	void Close();
+	GSTraceDraw* Add();
+	bool IsFull() const {return m_count >= m_maxcount;}
+	void Flush(uint64 frame);
+	operator bool() {return m_fp != NULL;}
+};
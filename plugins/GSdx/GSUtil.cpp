@@ -29,6 +29,7 @@
 #else
 #define SVN_REV 0
 #define SVN_MODS 0
+#include <sys/time.h>
 #endif
 
 const char* GSUtil::GetLibName()
@@ -188,6 +189,23 @@ bool GSUtil::CheckSSE()
 	return true;
 }
 
+uint32 GSUtil::GetMilliseconds()
+{
+	#ifdef _WINDOWS
+
+	return GetTickCount();
+
+	#else
+
+	timeval tv;
+
+	gettimeofday(&tv, NULL);
+
+	return (uint32)(tv.tv_sec * 1000 + tv.tv_usec / 1000);
+
+	#endif
+}
+
 #ifdef _WINDOWS
 
 bool GSUtil::CheckDirectX()
@@ -36,6 +36,8 @@ public:
 
 	static bool CheckSSE();
 
+	static uint32 GetMilliseconds();
+
 #ifdef _WINDOWS
 
 	static bool CheckDirectX();
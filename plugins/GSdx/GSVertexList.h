@@ -25,6 +25,7 @@ template <class Vertex> class GSVertexList
 {
 	void* m_base;
 	Vertex* m_v[3];
+	int m_tag[3]; // per slot, follows the vertex when the list is rotated
 	int m_count;
 
 public:
@@ -36,6 +37,7 @@ public:
 		for(int i = 0; i < countof(m_v); i++)
 		{
 			m_v[i] = &((Vertex*)m_base)[i];
+			m_tag[i] = -1;
 		}
 	}
 
@@ -53,6 +55,8 @@ public:
 	{
 		ASSERT(m_count < 3);
 
+		m_tag[m_v[m_count] - (Vertex*)m_base] = -1;
+
 		return *m_v[m_count++];
 	}
 
@@ -80,6 +84,21 @@ public:
 		v = *m_v[i];
 	}
 
+	__forceinline Vertex& GetAt(int i)
+	{
+		return *m_v[i];
+	}
+
+	__forceinline int& GetTag(int i)
+	{
+		return m_tag[m_v[i] - (Vertex*)m_base];
+	}
+
+	void ClearTags()
+	{
+		m_tag[0] = m_tag[1] = m_tag[2] = -1;
+	}
+
 	int GetCount()
 	{
 		return m_count;
@@ -105,6 +105,32 @@ void GSVertexTrace::Update(const GSVertexSW* v, int count, GS_PRIM_CLASS primcla
 	UpdateLOD();
 }
 
+void GSVertexTrace::Update(const GSVertexSW& min, const GSVertexSW& max, GS_PRIM_CLASS primclass)
+{
+	uint32 hash = Hash(primclass);
+
+	if(hash & (1 << 5))
+	{
+		m_min.c = GSVector4i(min.c).srl32(7);
+		m_max.c = GSVector4i(max.c).srl32(7);
+	}
+
+	m_min.p = min.p;
+	m_max.p = max.p;
+
+	if(m_state->PRIM->TME)
+	{
+		m_min.t = min.t;
+		m_max.t = max.t;
+	}
+
+	m_eq.value = (m_min.c == m_max.c).mask() | ((m_min.p == m_max.p).mask() << 16) | ((m_min.t == m_max.t).mask() << 20);
+
+	m_alpha.valid = false;
+
+	UpdateLOD();
+}
+
 void GSVertexTrace::Update(const GSVertexHW9* v, int count, GS_PRIM_CLASS primclass)
 {
 	m_map_hw9[Hash(primclass)](count, v, m_min, m_max);
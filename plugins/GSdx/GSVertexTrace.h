@@ -95,6 +95,7 @@ public:
 	GSVertexTrace(const GSState* state);
 
 	void Update(const GSVertexSW* v, int count, GS_PRIM_CLASS primclass);
+	void Update(const GSVertexSW& min, const GSVertexSW& max, GS_PRIM_CLASS primclass); // collected by the caller, t already divided by q
 	void Update(const GSVertexHW9* v, int count, GS_PRIM_CLASS primclass);
 	void Update(const GSVertexHW11* v, int count, GS_PRIM_CLASS primclass);
 	void Update(const GSVertexNull* v, int count, GS_PRIM_CLASS primclass) {}
@@ -0,0 +1,81 @@
+/*
+ *	Copyright (C) 2007-2009 Gabest
+ *	http://www.gabest.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with GNU Make; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 675 Mass Ave, Cambridge, MA 02139, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+// gsdx-replay: command line front end of GSReplayHash (see GS.cpp).
+//
+// Usage: gsdx-replay <path to libGSdx.so> [-f frames] <dump.gs> [more dumps...]
+//
+// Every dump is checked against <dump>.hash, which is recorded by the first run. Change
+// GSDrawScanline, GSRasterizer or GSLocalMemory, run it again, the output must not differ.
+
+#include <dlfcn.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+typedef int (*GSReplayHashFn)(const char* dump, const char* golden, int frames);
+
+int main(int argc, char* argv[])
+{
+	if(argc < 3)
+	{
+		fprintf(stderr, "Usage: %s <libGSdx.so> [-f frames] <dump.gs> [dump.gs...]\n", argv[0]);
+		return 1;
+	}
+
+	void* plugin = dlopen(argv[1], RTLD_NOW | RTLD_LOCAL);
+
+	if(plugin == NULL)
+	{
+		fprintf(stderr, "Could not load %s: %s\n", argv[1], dlerror());
+		return 1;
+	}
+
+	GSReplayHashFn GSReplayHash = (GSReplayHashFn)dlsym(plugin, "GSReplayHash");
+
+	if(GSReplayHash == NULL)
+	{
+		fprintf(stderr, "%s does not export GSReplayHash.\n", argv[1]);
+		dlclose(plugin);
+		return 1;
+	}
+
+	int frames = 0;
+	int failures = 0;
+
+	for(int i = 2; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+		{
+			frames = atoi(argv[++i]);
+			continue;
+		}
+
+		std::string golden = std::string(argv[i]) + ".hash";
+
+		if(GSReplayHash(argv[i], golden.c_str(), frames) != 0) failures++;
+	}
+
+	dlclose(plugin);
+
+	return failures ? 1 : 0;
+}
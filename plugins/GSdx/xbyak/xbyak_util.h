@@ -66,6 +66,29 @@ public:
 		__cpuid(reinterpret_cast<int*>(data), eaxIn);
 #else
 		__cpuid(eaxIn, data[0], data[1], data[2], data[3]);
+#endif
+	}
+	/*
+		cpuid with a sub-leaf in ecx (needed for leaf 7)
+		returns false if the compiler has no way of passing ecx
+	*/
+	static inline bool getCpuidEx(unsigned int eaxIn, unsigned int ecxIn, unsigned int data[4])
+	{
+#ifdef _WIN32
+	#if _MSC_VER >= 1500
+		__cpuidex(reinterpret_cast<int*>(data), eaxIn, ecxIn);
+		return true;
+	#else
+		(void)eaxIn; (void)ecxIn; (void)data;
+		return false;
+	#endif
+#elif defined(XBYAK32)
+		// ebx may be the PIC register, so swap it out instead of listing it as an output
+		__asm__ __volatile__("xchgl %%ebx, %1\ncpuid\nxchgl %%ebx, %1\n" : "=a"(data[0]), "=r"(data[1]), "=c"(data[2]), "=d"(data[3]) : "0"(eaxIn), "2"(ecxIn));
+		return true;
+#else
+		__asm__ __volatile__("cpuid\n" : "=a"(data[0]), "=b"(data[1]), "=c"(data[2]), "=d"(data[3]) : "0"(eaxIn), "2"(ecxIn));
+		return true;
 #endif
 	}
 	static inline uint64 getXfeature()
@@ -101,6 +124,7 @@ public:
 		tE3DN = 1 << 17,
 		tSSE4a = 1 << 18,
 		tRDTSCP = 1 << 19,
+		tAVX2 = 1 << 20,
 
 		tINTEL = 1 << 24,
 		tAMD = 1 << 25
@@ -110,6 +134,7 @@ public:
 	{
 		unsigned int data[4];
 		getCpuid(0, data);
+		const unsigned int maxLeaf = data[0];
 		static const char intel[] = "ntel";
 		static const char amd[] = "cAMD";
 		if (data[2] == get32bitAsBE(amd)) {
@@ -149,6 +174,11 @@ public:
 		if (data[3] & (1U << 23)) type_ |= tMMX;
 		if (data[3] & (1U << 25)) type_ |= tMMX2 | tSSE;
 		if (data[3] & (1U << 26)) type_ |= tSSE2;
+
+		// AVX2 is only usable if the OS saves the ymm state, which the tAVX check above covers
+		if ((type_ & tAVX) && maxLeaf >= 7 && getCpuidEx(7, 0, data)) {
+			if (data[1] & (1U << 5)) type_ |= tAVX2;
+		}
 	}
 	bool has(Type type) const
 	{
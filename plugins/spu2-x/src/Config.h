@@ -73,6 +73,7 @@ extern int dplLevel;
 extern u32 OutputModule;
 extern int SndOutLatencyMS;
 extern int SynchMode;
+extern bool ThreadedOutput;
 
 #ifndef __LINUX__
 extern wchar_t dspPlugin[];
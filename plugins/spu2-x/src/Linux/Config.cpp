@@ -51,6 +51,7 @@ bool _visual_debug_enabled = false; // windows only feature
 u32 OutputModule = 0;
 int SndOutLatencyMS = 300;
 int SynchMode = 0; // Time Stretch, Async or Disabled
+bool ThreadedOutput = false; // Run timestretch/output buffering on a separate thread
 static u32 OutputAPI = 0;
 
 int numSpeakers = 0;
@@ -86,6 +87,7 @@ void ReadSettings()
 
 	SndOutLatencyMS = CfgReadInt(L"OUTPUT",L"Latency", 300);
 	SynchMode = CfgReadInt( L"OUTPUT", L"Synch_Mode", 0);
+	ThreadedOutput = CfgReadBool( L"OUTPUT", L"Threaded_Output", false );
 
 	PortaudioOut->ReadSettings();
 	SoundtouchCfg::ReadSettings();
@@ -118,6 +120,7 @@ void WriteSettings()
 	CfgWriteStr(L"OUTPUT",L"Output_Module", mods[OutputModule]->GetIdent() );
 	CfgWriteInt(L"OUTPUT",L"Latency", SndOutLatencyMS);
 	CfgWriteInt(L"OUTPUT",L"Synch_Mode", SynchMode);
+	CfgWriteBool(L"OUTPUT",L"Threaded_Output", ThreadedOutput);
 
 	PortaudioOut->WriteSettings();
 	SoundtouchCfg::WriteSettings();
@@ -83,6 +83,7 @@ extern int  dspPluginModule;
 
 extern bool	dspPluginEnabled;
 extern int SynchMode;
+extern bool ThreadedOutput;
 
 namespace SoundtouchCfg
 {
@@ -0,0 +1,63 @@
+/* SPU2-X, A plugin for Emulating the Sound Processing Unit of the Playstation 2
+ * Developed and maintained by the Pcsx2 Development Team.
+ *
+ * SPU2-X is free software: you can redistribute it and/or modify it under the terms
+ * of the GNU Lesser General Public License as published by the Free Software Found-
+ * ation, either version 3 of the License, or (at your option) any later version.
+ *
+ * SPU2-X is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with SPU2-X.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// spu2x-replay: command line front end for s2r_benchmark (see Spu2replay.cpp).
+//
+// Usage: spu2x-replay <path to libspu2x.so> <file.s2r> [more .s2r files...]
+//
+// Each stream is mixed headless as fast as possible; the per-file report includes the
+// mixer throughput, per-stage timings and an output checksum.
+
+#include <dlfcn.h>
+#include <cstdio>
+
+typedef int (*S2RBenchmarkFn)(const char* filename);
+
+int main(int argc, char* argv[])
+{
+	if(argc < 3)
+	{
+		fprintf(stderr, "Usage: %s <libspu2x.so> <file.s2r> [file.s2r...]\n", argv[0]);
+		return 1;
+	}
+
+	void* plugin = dlopen(argv[1], RTLD_NOW | RTLD_LOCAL);
+
+	if(plugin == NULL)
+	{
+		fprintf(stderr, "Could not load %s: %s\n", argv[1], dlerror());
+		return 1;
+	}
+
+	S2RBenchmarkFn s2r_benchmark = (S2RBenchmarkFn)dlsym(plugin, "s2r_benchmark");
+
+	if(s2r_benchmark == NULL)
+	{
+		fprintf(stderr, "%s does not export s2r_benchmark.\n", argv[1]);
+		dlclose(plugin);
+		return 1;
+	}
+
+	int failures = 0;
+
+	for(int i = 2; i < argc; i++)
+	{
+		if(s2r_benchmark(argv[i]) != 0) failures++;
+	}
+
+	dlclose(plugin);
+
+	return failures ? 1 : 0;
+}
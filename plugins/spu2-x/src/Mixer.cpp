@@ -16,6 +16,8 @@
  */
 
 #include "Global.h"
+#include "Spu2replay.h"
+#include "Utilities/General.h"
 
 void ADMAOutLogWrite(void *lpData, u32 ulSize);
 
@@ -713,7 +715,9 @@ StereoOut32 V_Core::Mix( const VoiceMixSet& inVoices, const StereoOut32& Input,
 
 	WaveDump::WriteCore( Index, CoreSrc_PreReverb, TW );
 
+	const u64 benchTicks = replay_benchmark ? GetCPUTicks() : 0;
 	StereoOut32 RV = DoReverb( TW );
+	if( replay_benchmark ) replay_stats.TicksReverb += GetCPUTicks() - benchTicks;
 
 	WaveDump::WriteCore( Index, CoreSrc_PostReverb, RV );
 
@@ -824,8 +828,11 @@ void Mix()
 
 	// Todo: Replace me with memzero initializer!
 	VoiceMixSet VoiceData[2] = { VoiceMixSet::Empty, VoiceMixSet::Empty };	// mixed voice data for each core.
+
+	u64 benchTicks = replay_benchmark ? GetCPUTicks() : 0;
 	MixCoreVoices( VoiceData[0], 0 );
 	MixCoreVoices( VoiceData[1], 1 );
+	if( replay_benchmark ) replay_stats.TicksVoices += GetCPUTicks() - benchTicks;
 
 	StereoOut32 Ext( Cores[0].Mix( VoiceData[0], InputData[0], StereoOut32::Empty ) );
 
@@ -885,7 +892,15 @@ void Mix()
 	Out.Left *= FinalVolume;
 	Out.Right *= FinalVolume;
 	
-	SndBuffer::Write( Out );
+	if( replay_benchmark )
+	{
+		s2r_checksum( Out );
+		benchTicks = GetCPUTicks();
+		SndBuffer::Write( Out );
+		replay_stats.TicksOutput += GetCPUTicks() - benchTicks;
+	}
+	else
+		SndBuffer::Write( Out );
 
 	// Update AutoDMA output positioning
 	OutPos++;
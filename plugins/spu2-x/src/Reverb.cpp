@@ -18,6 +18,8 @@
 #include "Global.h"
 #include "Lowpass.h"
 
+#include <emmintrin.h>
+
 // Low pass filters: Change these to 32 for a speedup (benchmarks needed to see if
 // the speed gain is worth the quality drop)
 
@@ -52,6 +54,112 @@ void V_Core::Reverb_AdvanceBuffer()
 	}
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////
+// SSE2 helpers for the reverb engine.
+//
+// Everything here must stay bit-exact with the plain C versions it replaces (including
+// 32 bit wraparound), since reverb output is fed back into SPU2 memory.
+
+// Slots of the pre-wrapped address table built by RevbGetIndexerSSE.  The first 24
+// entries mirror the layout of V_ReverbBuffers, so they can be loaded as a block.
+enum RevbIndexSlot
+{
+	RVI_FB_SRC_A0 = 0,	RVI_FB_SRC_B0,	RVI_FB_SRC_A1,	RVI_FB_SRC_B1,
+	RVI_IIR_SRC_A0,		RVI_IIR_SRC_A1,	RVI_IIR_SRC_B0,	RVI_IIR_SRC_B1,
+	RVI_IIR_DEST_A0,	RVI_IIR_DEST_A1,RVI_IIR_DEST_B0,RVI_IIR_DEST_B1,
+	RVI_ACC_SRC_A0,		RVI_ACC_SRC_A1,	RVI_ACC_SRC_B0,	RVI_ACC_SRC_B1,
+	RVI_ACC_SRC_C0,		RVI_ACC_SRC_C1,	RVI_ACC_SRC_D0,	RVI_ACC_SRC_D1,
+	RVI_MIX_DEST_A0,	RVI_MIX_DEST_A1,RVI_MIX_DEST_B0,RVI_MIX_DEST_B1,
+	RVI_IIR_DEST2_A0,	RVI_IIR_DEST2_A1,RVI_IIR_DEST2_B0,RVI_IIR_DEST2_B1,
+
+	RVI_Count
+};
+
+static const int RevbIndexVecs = RVI_Count / 4;
+
+// Vectorized form of RevbGetIndexer: wraps all of the core's reverb buffer addresses at
+// once.  SSE2 only has signed compares, so both sides are biased by 0x80000000 to get the
+// same unsigned test as the scalar version.
+static __forceinline __m128i RevbWrapSSE( const __m128i& pos, const __m128i& end_biased, const __m128i& wrap )
+{
+	const __m128i bias = _mm_set1_epi32( 0x80000000 );
+	const __m128i over = _mm_cmpgt_epi32( _mm_xor_si128( pos, bias ), end_biased );
+	return _mm_add_epi32( pos, _mm_and_si128( wrap, over ) );
+}
+
+static __forceinline void RevbGetIndexerSSE( __m128i (&dest)[RevbIndexVecs], const V_ReverbBuffers& bufs,
+	u32 reverbX, u32 startA, u32 endA )
+{
+	const __m128i* src = (const __m128i*)&bufs.FB_SRC_A0;
+
+	const __m128i base	= _mm_set1_epi32( reverbX );
+	const __m128i end	= _mm_set1_epi32( endA ^ 0x80000000 );
+	const __m128i wrap	= _mm_set1_epi32( startA - (endA+1) );
+
+	for( int v=0; v<6; ++v )
+		dest[v] = RevbWrapSSE( _mm_add_epi32( base, _mm_loadu_si128( &src[v] ) ), end, wrap );
+
+	// IIR_DEST + 1 (the second IIR write address)
+	const __m128i dest2 = _mm_add_epi32( _mm_loadu_si128( &src[2] ), _mm_set1_epi32( 1 ) );
+	dest[6] = RevbWrapSSE( _mm_add_epi32( base, dest2 ), end, wrap );
+}
+
+// Returns true if the given IRQ address matches any of the reverb engine's accesses.
+static __forceinline bool RevbTestIrqSSE( const __m128i (&idx)[RevbIndexVecs], u32 irqa )
+{
+	const __m128i addr = _mm_set1_epi32( irqa );
+
+	__m128i hit = _mm_cmpeq_epi32( idx[0], addr );
+	for( int v=1; v<RevbIndexVecs; ++v )
+		hit = _mm_or_si128( hit, _mm_cmpeq_epi32( idx[v], addr ) );
+
+	return _mm_movemask_epi8( hit ) != 0;
+}
+
+// Low 32 bits of a 4x32 bit multiply (SSE2 lacks pmulld).  The low half of the product
+// is the same for signed and unsigned operands, so this matches s32 * s32 in C.
+static __forceinline __m128i mul32_lo( const __m128i& a, const __m128i& b )
+{
+	const __m128i even	= _mm_mul_epu32( a, b );
+	const __m128i odd	= _mm_mul_epu32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+	return _mm_unpacklo_epi32(
+		_mm_shuffle_epi32( even, _MM_SHUFFLE(0,0,2,0) ),
+		_mm_shuffle_epi32( odd,  _MM_SHUFFLE(0,0,2,0) )
+	);
+}
+
+// 8-tap downsampling FIR over the core's stereo history ring.  Rather than rotating the
+// ring to start at dbpos, the coefficients are pre-rotated: entry j of the ring is
+// weighted by coeffs[(j - dbpos) & 7].  Each table row is laid out as L,R pairs to match
+// the interleaved StereoOut32 history.
+static __forceinline StereoOut32 RevbDownsampleSSE( const StereoOut32 (&downbuf)[8], int dbpos, const s32 (&coeffs)[8] )
+{
+	static __aligned16 s32 rotated[8][16];
+	static bool rotated_init = false;
+
+	if( !rotated_init )
+	{
+		for( int pos=0; pos<8; ++pos )
+			for( int j=0; j<8; ++j )
+				rotated[pos][j*2+0] = rotated[pos][j*2+1] = coeffs[(j - pos) & 7];
+		rotated_init = true;
+	}
+
+	const __m128i* hist = (const __m128i*)downbuf;
+	const __m128i* coef = (const __m128i*)rotated[dbpos];
+
+	__m128i acc = mul32_lo( _mm_loadu_si128( &hist[0] ), coef[0] );
+	acc = _mm_add_epi32( acc, mul32_lo( _mm_loadu_si128( &hist[1] ), coef[1] ) );
+	acc = _mm_add_epi32( acc, mul32_lo( _mm_loadu_si128( &hist[2] ), coef[2] ) );
+	acc = _mm_add_epi32( acc, mul32_lo( _mm_loadu_si128( &hist[3] ), coef[3] ) );
+
+	// fold the two L,R pairs together and apply the final shift.
+	acc = _mm_add_epi32( acc, _mm_shuffle_epi32( acc, _MM_SHUFFLE(1,0,3,2) ) );
+	acc = _mm_srai_epi32( acc, 16 );
+
+	return StereoOut32( _mm_cvtsi128_si32( acc ), _mm_cvtsi128_si32( _mm_srli_si128( acc, 4 ) ) );
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////
 
 StereoOut32 V_Core::DoReverb( const StereoOut32& Input )
@@ -95,40 +203,48 @@ StereoOut32 V_Core::DoReverb( const StereoOut32& Input )
 		// Advance the current reverb buffer pointer, and cache the read/write addresses we'll be
 		// needing for this session of reverb.
 
-		const u32 src_a0 = RevbGetIndexer( RevBuffers.IIR_SRC_A0 );
-		const u32 src_a1 = RevbGetIndexer( RevBuffers.IIR_SRC_A1 );
-		const u32 src_b0 = RevbGetIndexer( RevBuffers.IIR_SRC_B0 );
-		const u32 src_b1 = RevbGetIndexer( RevBuffers.IIR_SRC_B1 );
-
-		const u32 dest_a0 = RevbGetIndexer( RevBuffers.IIR_DEST_A0 );
-		const u32 dest_a1 = RevbGetIndexer( RevBuffers.IIR_DEST_A1 );
-		const u32 dest_b0 = RevbGetIndexer( RevBuffers.IIR_DEST_B0 );
-		const u32 dest_b1 = RevbGetIndexer( RevBuffers.IIR_DEST_B1 );
-
-		const u32 dest2_a0 = RevbGetIndexer( RevBuffers.IIR_DEST_A0 + 1 );
-		const u32 dest2_a1 = RevbGetIndexer( RevBuffers.IIR_DEST_A1 + 1 );
-		const u32 dest2_b0 = RevbGetIndexer( RevBuffers.IIR_DEST_B0 + 1 );
-		const u32 dest2_b1 = RevbGetIndexer( RevBuffers.IIR_DEST_B1 + 1 );
-
-		const u32 acc_src_a0 = RevbGetIndexer( RevBuffers.ACC_SRC_A0 );
-		const u32 acc_src_b0 = RevbGetIndexer( RevBuffers.ACC_SRC_B0 );
-		const u32 acc_src_c0 = RevbGetIndexer( RevBuffers.ACC_SRC_C0 );
-		const u32 acc_src_d0 = RevbGetIndexer( RevBuffers.ACC_SRC_D0 );
-
-		const u32 acc_src_a1 = RevbGetIndexer( RevBuffers.ACC_SRC_A1 );
-		const u32 acc_src_b1 = RevbGetIndexer( RevBuffers.ACC_SRC_B1 );
-		const u32 acc_src_c1 = RevbGetIndexer( RevBuffers.ACC_SRC_C1 );
-		const u32 acc_src_d1 = RevbGetIndexer( RevBuffers.ACC_SRC_D1 );
-
-		const u32 fb_src_a0 = RevbGetIndexer( RevBuffers.FB_SRC_A0 );
-		const u32 fb_src_a1 = RevbGetIndexer( RevBuffers.FB_SRC_A1 );
-		const u32 fb_src_b0 = RevbGetIndexer( RevBuffers.FB_SRC_B0 );
-		const u32 fb_src_b1 = RevbGetIndexer( RevBuffers.FB_SRC_B1 );
-
-		const u32 mix_dest_a0 = RevbGetIndexer( RevBuffers.MIX_DEST_A0 );
-		const u32 mix_dest_a1 = RevbGetIndexer( RevBuffers.MIX_DEST_A1 );
-		const u32 mix_dest_b0 = RevbGetIndexer( RevBuffers.MIX_DEST_B0 );
-		const u32 mix_dest_b1 = RevbGetIndexer( RevBuffers.MIX_DEST_B1 );
+		__aligned16 union
+		{
+			__m128i	vec[RevbIndexVecs];
+			u32		addr[RVI_Count];
+		} idx;
+
+		RevbGetIndexerSSE( idx.vec, RevBuffers, ReverbX, EffectsStartA, EffectsEndA );
+
+		const u32 src_a0 = idx.addr[RVI_IIR_SRC_A0];
+		const u32 src_a1 = idx.addr[RVI_IIR_SRC_A1];
+		const u32 src_b0 = idx.addr[RVI_IIR_SRC_B0];
+		const u32 src_b1 = idx.addr[RVI_IIR_SRC_B1];
+
+		const u32 dest_a0 = idx.addr[RVI_IIR_DEST_A0];
+		const u32 dest_a1 = idx.addr[RVI_IIR_DEST_A1];
+		const u32 dest_b0 = idx.addr[RVI_IIR_DEST_B0];
+		const u32 dest_b1 = idx.addr[RVI_IIR_DEST_B1];
+
+		const u32 dest2_a0 = idx.addr[RVI_IIR_DEST2_A0];
+		const u32 dest2_a1 = idx.addr[RVI_IIR_DEST2_A1];
+		const u32 dest2_b0 = idx.addr[RVI_IIR_DEST2_B0];
+		const u32 dest2_b1 = idx.addr[RVI_IIR_DEST2_B1];
+
+		const u32 acc_src_a0 = idx.addr[RVI_ACC_SRC_A0];
+		const u32 acc_src_b0 = idx.addr[RVI_ACC_SRC_B0];
+		const u32 acc_src_c0 = idx.addr[RVI_ACC_SRC_C0];
+		const u32 acc_src_d0 = idx.addr[RVI_ACC_SRC_D0];
+
+		const u32 acc_src_a1 = idx.addr[RVI_ACC_SRC_A1];
+		const u32 acc_src_b1 = idx.addr[RVI_ACC_SRC_B1];
+		const u32 acc_src_c1 = idx.addr[RVI_ACC_SRC_C1];
+		const u32 acc_src_d1 = idx.addr[RVI_ACC_SRC_D1];
+
+		const u32 fb_src_a0 = idx.addr[RVI_FB_SRC_A0];
+		const u32 fb_src_a1 = idx.addr[RVI_FB_SRC_A1];
+		const u32 fb_src_b0 = idx.addr[RVI_FB_SRC_B0];
+		const u32 fb_src_b1 = idx.addr[RVI_FB_SRC_B1];
+
+		const u32 mix_dest_a0 = idx.addr[RVI_MIX_DEST_A0];
+		const u32 mix_dest_a1 = idx.addr[RVI_MIX_DEST_A1];
+		const u32 mix_dest_b0 = idx.addr[RVI_MIX_DEST_B0];
+		const u32 mix_dest_b1 = idx.addr[RVI_MIX_DEST_B1];
 
 		// -----------------------------------------
 		//          Optimized IRQ Testing !
@@ -137,31 +253,14 @@ StereoOut32 V_Core::DoReverb( const StereoOut32& Input )
 		// This test is enhanced by using the reverb effects area begin/end test as a
 		// shortcut, since all buffer addresses are within that area.  If the IRQA isn't
 		// within that zone then the "bulk" of the test is skipped, so this should only
-		// be a slowdown on a few evil games.
+		// be a slowdown on a few evil games.  The bulk itself is 7 SSE compares against
+		// the address table above.
 
 		for( uint i=0; i<2; i++ )
 		{
 			if( Cores[i].IRQEnable && ((Cores[i].IRQA >= EffectsStartA) && (Cores[i].IRQA <= EffectsEndA)) )
 			{
-				if(	(Cores[i].IRQA == src_a0)		||	(Cores[i].IRQA == src_a1)		||
-					(Cores[i].IRQA == src_b0)		||	(Cores[i].IRQA == src_b1)		||
-
-					(Cores[i].IRQA == dest_a0)		||	(Cores[i].IRQA == dest_a1)		||
-					(Cores[i].IRQA == dest_b0)		||	(Cores[i].IRQA == dest_b1)		||
-
-					(Cores[i].IRQA == dest2_a0)		||	(Cores[i].IRQA == dest2_a1)		||
-					(Cores[i].IRQA == dest2_b0)		||	(Cores[i].IRQA == dest2_b1)		||
-
-					(Cores[i].IRQA == acc_src_a0)	||	(Cores[i].IRQA == acc_src_a1)	||
-					(Cores[i].IRQA == acc_src_b0)	||	(Cores[i].IRQA == acc_src_b1)	||
-					(Cores[i].IRQA == acc_src_c0)	||	(Cores[i].IRQA == acc_src_c1)	||
-					(Cores[i].IRQA == acc_src_d0)	||	(Cores[i].IRQA == acc_src_d1)	||
-
-					(Cores[i].IRQA == fb_src_a0)	||	(Cores[i].IRQA == fb_src_a1)	||
-					(Cores[i].IRQA == fb_src_b0)	||	(Cores[i].IRQA == fb_src_b1)	||
-
-					(Cores[i].IRQA == mix_dest_a0)	||	(Cores[i].IRQA == mix_dest_a1)	||
-					(Cores[i].IRQA == mix_dest_b0)	||	(Cores[i].IRQA == mix_dest_b1) )
+				if( RevbTestIrqSSE( idx.vec, Cores[i].IRQA ) )
 				{
 					//printf("Core %d IRQ Called (Reverb). IRQA = %x\n",i,addr);
 					SetIrqCall(i);
@@ -173,16 +272,7 @@ StereoOut32 V_Core::DoReverb( const StereoOut32& Input )
 		//         Begin Reverb Processing !
 		// -----------------------------------------
 
-		StereoOut32 INPUT_SAMPLE;
-
-		for( int x=0; x<8; ++x )
-		{
-			INPUT_SAMPLE.Left += (downbuf[(dbpos+x)&7].Left * downcoeffs[x]);
-			INPUT_SAMPLE.Right += (downbuf[(dbpos+x)&7].Right * downcoeffs[x]);
-		}
-
-		INPUT_SAMPLE.Left  >>= 16;
-		INPUT_SAMPLE.Right >>= 16;
+		const StereoOut32 INPUT_SAMPLE( RevbDownsampleSSE( downbuf, dbpos, downcoeffs ) );
 
 		s32 input_L = INPUT_SAMPLE.Left * Revb.IN_COEF_L;
 		s32 input_R = INPUT_SAMPLE.Right * Revb.IN_COEF_R;
@@ -16,6 +16,9 @@
  */
 
 #include "Global.h"
+#include "Utilities/Threading.h"
+
+using namespace Threading;
 
 
 StereoOut32 StereoOut32::Empty( 0, 0 );
@@ -120,6 +123,16 @@ StereoOut32* SndBuffer::sndTempBuffer = NULL;
 StereoOut16* SndBuffer::sndTempBuffer16 = NULL;
 int SndBuffer::sndTempProgress = 0;
 
+StereoOut32* SndBuffer::m_mixqueue = NULL;
+__aligned(4) volatile s32 SndBuffer::m_mixqueue_rpos;
+__aligned(4) volatile s32 SndBuffer::m_mixqueue_wpos;
+__aligned(4) volatile s32 SndBuffer::m_mixqueue_exit;
+bool SndBuffer::m_mixthread_running = false;
+MixQueueStats SndBuffer::m_mixqueue_stats;
+
+static pthread_t	MixThread;
+static Semaphore	MixThreadEvent;
+
 int GetAlignedBufferSize( int comp )
 {
 	return (comp + SndOutPacketSize-1) & ~(SndOutPacketSize-1);
@@ -404,10 +417,16 @@ void SndBuffer::Init()
 
 	// initialize module
 	if( mods[OutputModule]->Init() == -1 ) _InitFail();
+
+	// null output doesn't buffer anything, so there's nothing to offload either.
+	if( ThreadedOutput && (mods[OutputModule] != &NullOut) )
+		_StartMixThread();
 }
 
 void SndBuffer::Cleanup()
 {
+	_StopMixThread();
+
 	mods[OutputModule]->Close();
 
 	soundtouchCleanup();
@@ -424,6 +443,9 @@ int SndBuffer::ssFreeze = 0;
 
 void SndBuffer::ClearContents()
 {
+	// The output thread owns SoundTouch while it's running; let it finish first.
+	SyncMixThread();
+
 	SndBuffer::soundtouchClearContents();
 	SndBuffer::ssFreeze = 256; //Delays sound output for about 1 second.
 }
@@ -444,11 +466,22 @@ void SndBuffer::Write( const StereoOut32& Sample )
 	if(sndTempProgress < SndOutPacketSize) return;
 	sndTempProgress = 0;
 
+	if( m_mixthread_running )
+		_QueuePacket( sndTempBuffer );
+	else
+		_ProcessPacket( sndTempBuffer );
+}
+
+// Runs the post-mixing stages (savestate silence, DSP plugin, timestretching) for one
+// full packet and commits the result to the output buffer.  Called from the mixing
+// thread directly, or from the output thread when ThreadedOutput is enabled.
+void SndBuffer::_ProcessPacket( StereoOut32* packet )
+{
 	//Don't play anything directly after loading a savestate, avoids static killing your speakers.
 	if ( ssFreeze > 0 )
 	{
 		ssFreeze--;
-		memset( sndTempBuffer, 0, sizeof(StereoOut32) * SndOutPacketSize ); // Play silence
+		memset( packet, 0, sizeof(StereoOut32) * SndOutPacketSize ); // Play silence
 	}
 #ifndef __LINUX__
 	if( dspPluginEnabled )
@@ -456,19 +489,19 @@ void SndBuffer::Write( const StereoOut32& Sample )
 		// Convert in, send to winamp DSP, and convert out.
 
 		int ei= m_dsp_progress;
-		for( int i=0; i<SndOutPacketSize; ++i, ++ei ) { sndTempBuffer16[ei] = sndTempBuffer[i].DownSample(); }
+		for( int i=0; i<SndOutPacketSize; ++i, ++ei ) { sndTempBuffer16[ei] = packet[i].DownSample(); }
 		m_dsp_progress += DspProcess( (s16*)sndTempBuffer16 + m_dsp_progress, SndOutPacketSize );
 
 		// Some ugly code to ensure full packet handling:
 		ei = 0;
 		while( m_dsp_progress >= SndOutPacketSize )
 		{
-			for( int i=0; i<SndOutPacketSize; ++i, ++ei ) { sndTempBuffer[i] = sndTempBuffer16[ei].UpSample(); }
+			for( int i=0; i<SndOutPacketSize; ++i, ++ei ) { packet[i] = sndTempBuffer16[ei].UpSample(); }
 
 			if( SynchMode == 0 ) // TimeStrech on
-				timeStretchWrite();
+				timeStretchWrite( packet );
 			else
-				_WriteSamples(sndTempBuffer, SndOutPacketSize);
+				_WriteSamples(packet, SndOutPacketSize);
 
 			m_dsp_progress -= SndOutPacketSize;
 		}
@@ -485,10 +518,127 @@ void SndBuffer::Write( const StereoOut32& Sample )
 	else
 	{
 		if( SynchMode == 0 ) // TimeStrech on
-			timeStretchWrite();
+			timeStretchWrite( packet );
 		else
-			_WriteSamples(sndTempBuffer, SndOutPacketSize);
+			_WriteSamples(packet, SndOutPacketSize);
+	}
+}
+
+// --------------------------------------------------------------------------------------
+//  Output stage thread
+// --------------------------------------------------------------------------------------
+// Voice decoding, effects and the final mix stay on the IOP thread: IRQ address checks,
+// DMA interrupt counters and ADMA feeds are all driven from inside Mix(), and moving them
+// off-thread would break IRQ timing.  Everything after the mix (DSP plugin, SoundTouch
+// and the output buffer) only consumes finished samples, so it runs here instead.
+
+int SndBuffer::_GetMixQueueDepth()
+{
+	return (AtomicRead( m_mixqueue_wpos ) - AtomicRead( m_mixqueue_rpos )) & MixQueueMask;
+}
+
+void SndBuffer::_QueuePacket( const StereoOut32* packet )
+{
+	// One slot is always kept free so that rpos == wpos means empty.
+	int depth = _GetMixQueueDepth();
+	if( depth >= MixQueueMask )
+	{
+		++m_mixqueue_stats.Stalls;
+		do {
+			MixThreadEvent.Post();
+			Threading::Timeslice();
+			depth = _GetMixQueueDepth();
+		} while( depth >= MixQueueMask );
+	}
+
+	memcpy( &m_mixqueue[m_mixqueue_wpos * SndOutPacketSize], packet, sizeof(StereoOut32) * SndOutPacketSize );
+	AtomicExchange( m_mixqueue_wpos, (m_mixqueue_wpos + 1) & MixQueueMask );
+
+	++m_mixqueue_stats.PacketsQueued;
+	m_mixqueue_stats.DepthTotal += depth + 1;
+	if( (u32)(depth + 1) > m_mixqueue_stats.DepthPeak )
+		m_mixqueue_stats.DepthPeak = depth + 1;
+
+	MixThreadEvent.Post();
+}
+
+void* SndBuffer::MixThreadProc( void* )
+{
+	for(;;)
+	{
+		MixThreadEvent.WaitWithoutYield();
+
+		while( AtomicRead( m_mixqueue_rpos ) != AtomicRead( m_mixqueue_wpos ) )
+		{
+			_ProcessPacket( &m_mixqueue[m_mixqueue_rpos * SndOutPacketSize] );
+			AtomicExchange( m_mixqueue_rpos, (m_mixqueue_rpos + 1) & MixQueueMask );
+		}
+
+		if( AtomicRead( m_mixqueue_exit ) ) break;
 	}
+	return NULL;
+}
+
+// Blocks until the output thread has consumed every queued packet.  Must be called by the
+// mixing thread before touching any state the output thread owns (SoundTouch, DSP).
+void SndBuffer::SyncMixThread()
+{
+	if( !m_mixthread_running ) return;
+
+	++m_mixqueue_stats.Syncs;
+	while( _GetMixQueueDepth() != 0 )
+	{
+		MixThreadEvent.Post();
+		Threading::Timeslice();
+	}
+}
+
+void SndBuffer::_StartMixThread()
+{
+	memset( &m_mixqueue_stats, 0, sizeof(m_mixqueue_stats) );
+	m_mixqueue_rpos = 0;
+	m_mixqueue_wpos = 0;
+	m_mixqueue_exit = 0;
+
+	try
+	{
+		m_mixqueue = new StereoOut32[MixQueuePackets * SndOutPacketSize];
+	}
+	catch( std::bad_alloc& )
+	{
+		ConLog( "* SPU2-X: Out of memory allocating the output queue; mixing inline.\n" );
+		return;
+	}
+
+	MixThreadEvent.Reset();
+	if( pthread_create( &MixThread, NULL, MixThreadProc, NULL ) != 0 )
+	{
+		ConLog( "* SPU2-X: Could not start the output thread; mixing inline.\n" );
+		safe_delete_array( m_mixqueue );
+		return;
+	}
+
+	m_mixthread_running = true;
+}
+
+void SndBuffer::_StopMixThread()
+{
+	if( !m_mixthread_running ) return;
+
+	SyncMixThread();
+	AtomicExchange( m_mixqueue_exit, 1 );
+	MixThreadEvent.Post();
+	pthread_join( MixThread, NULL );
+	m_mixthread_running = false;
+
+	if( MsgToConsole() && m_mixqueue_stats.PacketsQueued )
+	{
+		const MixQueueStats& st( m_mixqueue_stats );
+		ConLog( "* SPU2-X: Output thread: %u packets, queue depth avg %.1f / peak %u (of %d), %u stalls, %u syncs\n",
+			st.PacketsQueued, (float)st.DepthTotal / st.PacketsQueued, st.DepthPeak, MixQueueMask, st.Stalls, st.Syncs );
+	}
+
+	safe_delete_array( m_mixqueue );
 }
 
 s32 SndBuffer::Test()
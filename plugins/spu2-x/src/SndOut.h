@@ -375,6 +375,16 @@ struct Stereo51Out32
 	}
 };
 
+// Counters for the output stage thread (see SndBuffer::MixThreadProc).
+struct MixQueueStats
+{
+	u32 PacketsQueued;		// packets handed to the output thread
+	u32 DepthTotal;			// sum of queue depths sampled at each push (for averaging)
+	u32 DepthPeak;			// highest queue depth seen
+	u32 Stalls;				// times the mixer had to wait for a free queue slot
+	u32 Syncs;				// full drains requested by the mixer (savestates, shutdown)
+};
+
 // Developer Note: This is a static class only (all static members).
 class SndBuffer
 {
@@ -403,13 +413,27 @@ private:
 	static float eTempo;
 	static int ssFreeze;
 
+	// Output stage thread: the mixer hands finished packets to this thread through a
+	// single-producer/single-consumer ring, and it runs DSP/timestretch/buffering.
+	// MixQueuePackets must be a power of 2.
+	static const int MixQueuePackets = 64;
+	static const int MixQueueMask = MixQueuePackets - 1;
+
+	static StereoOut32* m_mixqueue;
+	static __aligned(4) volatile s32 m_mixqueue_rpos;	// Only modified by the output thread
+	static __aligned(4) volatile s32 m_mixqueue_wpos;	// Only modified by the mixing thread
+	static __aligned(4) volatile s32 m_mixqueue_exit;
+	static bool m_mixthread_running;
+
+	static MixQueueStats m_mixqueue_stats;
+
 	static void _InitFail();
 	static bool CheckUnderrunStatus( int& nSamples, int& quietSampleCount );
 
 	static void soundtouchInit();
 	static void soundtouchClearContents();
 	static void soundtouchCleanup();
-	static void timeStretchWrite();
+	static void timeStretchWrite( StereoOut32* packet );
 	static void timeStretchUnderrun();
 	static s32 timeStretchOverrun();
 
@@ -428,8 +452,18 @@ private:
 	static void _ReadSamples_Internal(StereoOut32 *bData, int nSamples);
 
 	static int _GetApproximateDataInBuffer(); 
-	
+
+	static void _ProcessPacket( StereoOut32* packet );
+	static void _QueuePacket( const StereoOut32* packet );
+	static void _StartMixThread();
+	static void _StopMixThread();
+	static int _GetMixQueueDepth();
+
 public:
+	static void* MixThreadProc( void* );
+	static void SyncMixThread();
+	static const MixQueueStats& GetMixQueueStats() { return m_mixqueue_stats; }
+
 	static void UpdateTempoChangeAsyncMixing();
 	static void Init();
 	static void Cleanup();
@@ -18,6 +18,7 @@
 
 #include "Global.h"
 #include "PS2E-spu2.h"
+#include "Utilities/General.h"
 
 #ifdef _MSC_VER
 #	include "Windows.h"
@@ -105,6 +106,36 @@ double HighResScale;
 
 bool Running = false;
 
+bool replay_benchmark = false;
+ReplayBenchStats replay_stats;
+
+#if defined(__LINUX__) && !defined(ENABLE_NEW_IOPDMA_SPU2)
+// PS2E-spu2.h leaves these out on Linux (see the note there).
+EXPORT_C_(void) SPU2writeDMA4Mem(u16 *pMem, u32 size);
+EXPORT_C_(void) SPU2interruptDMA4();
+EXPORT_C_(void) SPU2writeDMA7Mem(u16 *pMem, u32 size);
+EXPORT_C_(void) SPU2interruptDMA7();
+EXPORT_C_(void) SPU2irqCallback(void (*SPU2callback)(),void (*DMA4callback)(),void (*DMA7callback)());
+#endif
+
+void dummy1()
+{
+}
+
+void dummy4()
+{
+#ifndef ENABLE_NEW_IOPDMA_SPU2
+	SPU2interruptDMA4();
+#endif
+}
+
+void dummy7()
+{
+#ifndef ENABLE_NEW_IOPDMA_SPU2
+	SPU2interruptDMA7();
+#endif
+}
+
 #ifdef _MSC_VER
 
 int conprintf(const char* fmt, ...)
@@ -135,24 +166,6 @@ int conprintf(const char* fmt, ...)
 #endif
 }
 
-void dummy1()
-{
-}
-
-void dummy4()
-{
-#ifndef ENABLE_NEW_IOPDMA_SPU2
-	SPU2interruptDMA4();
-#endif
-}
-
-void dummy7()
-{
-#ifndef ENABLE_NEW_IOPDMA_SPU2
-	SPU2interruptDMA7();
-#endif
-}
-
 u64 HighResFrequency()
 {
 	u64 freq;
@@ -317,3 +330,151 @@ Finish:
 #endif
 }
 #endif
+
+// --------------------------------------------------------------------------------------
+//  s2r_benchmark
+// --------------------------------------------------------------------------------------
+// Headless replay of an .s2r register stream: no output device, no real-time pacing.
+// The stream is mixed as fast as possible through the normal Mix() path (timestretcher
+// included, drained at exactly 48khz of emulated time so its behavior is reproducible),
+// and a checksum of the mixer output is printed for bit-exact regression testing.
+//
+// Returns 0 on success, -1 if the file couldn't be replayed.
+
+EXPORT_C_(s32) s2r_benchmark(const char* filename)
+{
+#ifdef ENABLE_NEW_IOPDMA_SPU2
+	fprintf(stderr, "s2r_benchmark: not supported with ENABLE_NEW_IOPDMA_SPU2.\n");
+	return -1;
+#else
+	FILE* file = fopen(filename, "rb");
+
+	if(!file)
+	{
+		fprintf(stderr, "s2r_benchmark: could not open %s.\n", filename);
+		return -1;
+	}
+
+	u32 firstcycle;
+	if(fread(&firstcycle, 4, 1, file) < 1)
+	{
+		fprintf(stderr, "s2r_benchmark: %s is not an s2r file.\n", filename);
+		fclose(file);
+		return -1;
+	}
+
+	replay_mode = true;
+
+	if(SPU2init() != 0)
+	{
+		fclose(file);
+		replay_mode = false;
+		return -1;
+	}
+
+	// Force a device-free, reproducible configuration on top of whatever the ini says.
+	OutputModule	= FindOutputModuleById( L"nullout" );
+	ThreadedOutput	= false;
+	FinalVolume		= 1.0f;
+
+	SPU2irqCallback(dummy1, dummy4, dummy7);
+	CurrentIOPCycle = 0;
+	SPU2setClockPtr(&CurrentIOPCycle);
+
+	memset(&replay_stats, 0, sizeof(replay_stats));
+	replay_stats.Checksum = 0xcbf29ce484222325ULL;	// FNV-1a offset basis
+	replay_benchmark = true;
+
+	SPU2open(NULL);
+
+	StereoOut16 drainbuf[SndOutPacketSize];
+	u64 drained = 0;
+	u32 events = 0;
+	bool failed = false;
+
+	const u64 startTicks = GetCPUTicks();
+
+	for(;;)
+	{
+		u32 ccycle, sval, tval = 0;
+
+		if(fread(&ccycle, 4, 1, file) < 1) break;
+		if(fread(&sval, 4, 1, file) < 1) break;
+
+		const u32 evid = sval >> 29;
+		sval &= 0x1FFFFFFF;
+
+		// Advance in at most 10ms steps (like the real-time replay does), which keeps
+		// TimeUpdate's sanity clamp from ever kicking in on long idle periods.
+		const u32 TargetCycle = ccycle * 768;
+		while(TargetCycle > CurrentIOPCycle)
+		{
+			CurrentIOPCycle += std::min(TargetCycle - CurrentIOPCycle, IOPCiclesPerMS * 10);
+			SPU2async(0);
+
+			while(replay_stats.Samples - drained >= SndOutPacketSize)
+			{
+				SndBuffer::ReadSamples(drainbuf);
+				drained += SndOutPacketSize;
+			}
+		}
+
+		switch(evid)
+		{
+			case 0:
+				SPU2read(sval);
+			break;
+
+			case 1:
+				if(fread(&tval, 2, 1, file) < 1) { failed = true; break; }
+				SPU2write(sval, tval);
+			break;
+
+			case 2:
+			case 3:
+				if((sval > ArraySize(dmabuffer)) || (fread(dmabuffer, 2, sval, file) < sval)) { failed = true; break; }
+				if(evid == 2)
+					SPU2writeDMA4Mem(dmabuffer, sval);
+				else
+					SPU2writeDMA7Mem(dmabuffer, sval);
+			break;
+
+			default:
+				failed = true;
+			break;
+		}
+
+		if(failed) break;
+		events++;
+	}
+
+	const double elapsed = (double)(GetCPUTicks() - startTicks) / GetTickFrequency();
+	const double tickScale = 1.0 / GetTickFrequency();
+
+	replay_benchmark = false;
+
+	SPU2close();
+	SPU2shutdown();
+	fclose(file);
+
+	replay_mode = false;
+
+	if(failed)
+	{
+		fprintf(stderr, "s2r_benchmark: %s is truncated or corrupt (after %u events).\n", filename, events);
+		return -1;
+	}
+
+	const ReplayBenchStats& st(replay_stats);
+	const double seconds = (double)st.Samples / SampleRate;
+
+	printf("%s: %u events, %llu samples (%.2f s of audio) in %.3f s\n", filename, events, st.Samples, seconds, elapsed);
+	printf("  %.0f samples/sec (%.1fx realtime)\n", elapsed > 0 ? st.Samples / elapsed : 0.0, elapsed > 0 ? seconds / elapsed : 0.0);
+	printf("  voices %.3f s | reverb %.3f s | timestretch/output %.3f s\n",
+		st.TicksVoices * tickScale, st.TicksReverb * tickScale, st.TicksOutput * tickScale);
+	printf("  interpolation %d, effects %s, checksum %016llx\n",
+		Interpolation, EffectsDisabled ? "off" : "on", st.Checksum);
+
+	return 0;
+#endif
+}
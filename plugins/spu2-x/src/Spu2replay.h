@@ -29,3 +29,28 @@ void s2r_writedma7(u32 ticks,u16*data,u32 len);
 void s2r_close();
 
 extern bool replay_mode;
+
+// s2r benchmarking (see s2r_benchmark): per-stage mixer timings, in GetCPUTicks units,
+// plus a running checksum of the final mixer output.
+struct ReplayBenchStats
+{
+	u64 Samples;
+	u64 Checksum;
+
+	u64 TicksVoices;	// MixCoreVoices, both cores
+	u64 TicksReverb;	// DoReverb, both cores
+	u64 TicksOutput;	// SndBuffer::Write (timestretch + output buffering)
+};
+
+extern bool replay_benchmark;
+extern ReplayBenchStats replay_stats;
+
+static __forceinline void s2r_checksum( const StereoOut32& out )
+{
+	// FNV-1a over the two 32 bit channel values
+	const u32 v[2] = { (u32)out.Left, (u32)out.Right };
+	const u8* p = (const u8*)v;
+	for( uint i=0; i<sizeof(v); ++i )
+		replay_stats.Checksum = (replay_stats.Checksum ^ p[i]) * 0x100000001b3ULL;
+	++replay_stats.Samples;
+}
@@ -424,7 +424,7 @@ static void CvtPacketToInt( StereoOut32* srcdest, uint size )
 		*dest = (StereoOut32)*src;
 }
 
-void SndBuffer::timeStretchWrite()
+void SndBuffer::timeStretchWrite( StereoOut32* packet )
 {
 	bool progress = false;
 
@@ -435,19 +435,19 @@ void SndBuffer::timeStretchWrite()
 	// data prediction to make the timestretcher more responsive.
 
 	PredictDataWrite( (int)( SndOutPacketSize / eTempo ) );
-	CvtPacketToFloat( sndTempBuffer );
+	CvtPacketToFloat( packet );
 
-	pSoundTouch->putSamples( (float*)sndTempBuffer, SndOutPacketSize );
+	pSoundTouch->putSamples( (float*)packet, SndOutPacketSize );
 
 	int tempProgress;
-	while( tempProgress = pSoundTouch->receiveSamples( (float*)sndTempBuffer, SndOutPacketSize),
+	while( tempProgress = pSoundTouch->receiveSamples( (float*)packet, SndOutPacketSize),
 		tempProgress != 0 )
 	{
 		// Hint: It's assumed that pSoundTouch will return chunks of 128 bytes (it always does as
 		// long as the SSE optimizations are enabled), which means we can do our own SSE opts here.
 
-		CvtPacketToInt( sndTempBuffer, tempProgress );
-		_WriteSamples( sndTempBuffer, tempProgress );
+		CvtPacketToInt( packet, tempProgress );
+		_WriteSamples( packet, tempProgress );
 		progress = true;
 	}
 
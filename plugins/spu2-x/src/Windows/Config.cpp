@@ -45,6 +45,7 @@ bool postprocess_filter_dealias = false;
 // OUTPUT
 int SndOutLatencyMS = 150;
 int SynchMode = 0; // Time Stretch, Async or Disabled
+bool ThreadedOutput = false; // Run timestretch/output buffering on a separate thread
 
 u32 OutputModule = 0;
 
@@ -67,6 +68,7 @@ void ReadSettings()
 	Interpolation = CfgReadInt( L"MIXING",L"Interpolation", 4 );
 
 	SynchMode = CfgReadInt( L"OUTPUT", L"Synch_Mode", 0);
+	ThreadedOutput = CfgReadBool( L"OUTPUT", L"Threaded_Output", false );
 	EffectsDisabled = CfgReadBool( L"MIXING", L"Disable_Effects", false );
 	postprocess_filter_dealias = CfgReadBool( L"MIXING", L"DealiasFilter", false );
 	FinalVolume = ((float)CfgReadInt( L"MIXING", L"FinalVolume", 100 )) / 100;
@@ -127,6 +129,7 @@ void WriteSettings()
 	CfgWriteStr(L"OUTPUT",L"Output_Module", mods[OutputModule]->GetIdent() );
 	CfgWriteInt(L"OUTPUT",L"Latency", SndOutLatencyMS);
 	CfgWriteInt(L"OUTPUT",L"Synch_Mode", SynchMode);
+	CfgWriteBool(L"OUTPUT",L"Threaded_Output", ThreadedOutput);
 	CfgWriteInt(L"OUTPUT",L"SpeakerConfiguration", numSpeakers);
 	CfgWriteInt( L"OUTPUT", L"DplDecodingLevel", dplLevel);
 
@@ -0,0 +1,287 @@
+//
+// gstrace2json - converts the per-draw trace of GSdx (the "trace" option) to the
+// json format of chrome://tracing
+//
+// Every draw becomes one slice on the timeline of each rasterizer worker that had
+// a part of it, vsyncs are instant events. With -s the selectors with the most
+// rasterizer time are also listed on stderr.
+//
+// The record layout must match GSTraceDraw in plugins/GSdx/GSTrace.h, the file
+// header has the version and record size to catch mismatches.
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include <stdint.h>
+
+using namespace std;
+
+#define GSTRACE_VERSION 1
+#define GSTRACE_WORKERS 16
+
+enum
+{
+	GSTRACE_MERGED = 1,
+	GSTRACE_SOLIDRECT = 2,
+	GSTRACE_SYNCPOINT = 4,
+};
+
+struct GSTraceDraw
+{
+	uint64_t sel;
+	uint64_t tsc;
+	uint32_t frame;
+	uint16_t primclass;
+	uint16_t flags;
+	uint32_t count;
+	uint32_t prims;
+	int16_t bbox[4];
+	uint16_t tex_hit;
+	uint16_t tex_miss;
+	uint32_t reserved;
+	struct {uint32_t start, ticks, pixels, reserved;} worker[GSTRACE_WORKERS];
+};
+
+struct Block
+{
+	uint32_t count;
+	uint32_t ms;
+	uint64_t tsc;
+	uint64_t frame;
+	vector<GSTraceDraw> draws;
+};
+
+struct SelStats
+{
+	uint64_t ticks;
+	uint64_t pixels;
+	uint32_t draws;
+
+	SelStats() : ticks(0), pixels(0), draws(0) {}
+};
+
+static const char* s_primclass[] = {"point", "line", "triangle", "sprite"};
+
+static void usage()
+{
+	fprintf(stderr, "usage: gstrace2json [-s] [-f <tsc MHz>] <trace file> [<json file>]\n");
+}
+
+int main(int argc, char** argv)
+{
+	bool summary = false;
+	double mhz = 0;
+	const char* src = NULL;
+	const char* dst = NULL;
+
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-s") == 0)
+		{
+			summary = true;
+		}
+		else if(strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+		{
+			mhz = atof(argv[++i]);
+		}
+		else if(src == NULL)
+		{
+			src = argv[i];
+		}
+		else if(dst == NULL)
+		{
+			dst = argv[i];
+		}
+		else
+		{
+			usage();
+
+			return 1;
+		}
+	}
+
+	if(src == NULL)
+	{
+		usage();
+
+		return 1;
+	}
+
+	FILE* fp = fopen(src, "rb");
+
+	if(fp == NULL)
+	{
+		fprintf(stderr, "cannot open %s\n", src);
+
+		return 1;
+	}
+
+	char id[4];
+	uint32_t header[3];
+
+	if(fread(id, 4, 1, fp) != 1 || memcmp(id, "GSTR", 4) != 0 || fread(header, sizeof(header), 1, fp) != 1)
+	{
+		fprintf(stderr, "%s is not a GSdx trace\n", src);
+
+		fclose(fp);
+
+		return 1;
+	}
+
+	if(header[0] != GSTRACE_VERSION || header[1] != sizeof(GSTraceDraw) || header[2] != GSTRACE_WORKERS)
+	{
+		fprintf(stderr, "%s has version %u, record size %u, %u workers, expected %u, %u, %u\n", 
+			src, header[0], header[1], header[2], GSTRACE_VERSION, (uint32_t)sizeof(GSTraceDraw), GSTRACE_WORKERS);
+
+		fclose(fp);
+
+		return 1;
+	}
+
+	vector<Block> blocks;
+
+	while(1)
+	{
+		Block b;
+
+		if(fread(&b.count, 4, 1, fp) != 1
+		|| fread(&b.ms, 4, 1, fp) != 1
+		|| fread(&b.tsc, 8, 1, fp) != 1
+		|| fread(&b.frame, 8, 1, fp) != 1)
+		{
+			break;
+		}
+
+		b.draws.resize(b.count);
+
+		if(b.count > 0 && fread(&b.draws[0], sizeof(GSTraceDraw), b.count, fp) != b.count)
+		{
+			fprintf(stderr, "%s is truncated\n", src);
+
+			break;
+		}
+
+		blocks.push_back(b);
+	}
+
+	fclose(fp);
+
+	if(blocks.empty())
+	{
+		fprintf(stderr, "%s has no draws\n", src);
+
+		return 1;
+	}
+
+	if(mhz <= 0)
+	{
+		const Block& first = blocks.front();
+		const Block& last = blocks.back();
+
+		if(last.ms - first.ms >= 100)
+		{
+			mhz = (double)(last.tsc - first.tsc) / (last.ms - first.ms) / 1000;
+		}
+		else
+		{
+			mhz = 1000;
+
+			fprintf(stderr, "trace is too short to measure the tsc frequency, assuming %.0f MHz (use -f)\n", mhz);
+		}
+	}
+
+	FILE* out = dst != NULL ? fopen(dst, "w") : stdout;
+
+	if(out == NULL)
+	{
+		fprintf(stderr, "cannot open %s\n", dst);
+
+		return 1;
+	}
+
+	uint64_t base = blocks.front().draws.empty() ? blocks.front().tsc : std::min(blocks.front().tsc, blocks.front().draws[0].tsc);
+
+	map<uint64_t, SelStats> sels;
+
+	bool comma = false;
+
+	fprintf(out, "{\"traceEvents\":[\n");
+
+	for(size_t i = 0; i < blocks.size(); i++)
+	{
+		const Block& b = blocks[i];
+
+		for(size_t j = 0; j < b.draws.size(); j++)
+		{
+			const GSTraceDraw& d = b.draws[j];
+
+			SelStats& s = sels[d.sel];
+
+			s.draws++;
+
+			for(int k = 0; k < GSTRACE_WORKERS; k++)
+			{
+				if(d.worker[k].ticks == 0)
+				{
+					continue;
+				}
+
+				s.ticks += d.worker[k].ticks;
+				s.pixels += d.worker[k].pixels;
+
+				double ts = (double)(int64_t)(d.tsc - base + (int32_t)d.worker[k].start) / mhz;
+				double dur = (double)d.worker[k].ticks / mhz;
+
+				fprintf(out, "%s{\"name\":\"%016llx\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+					"\"args\":{\"frame\":%u,\"count\":%u,\"prims\":%u,\"pixels\":%u,\"bbox\":[%d,%d,%d,%d],\"tex_hit\":%u,\"tex_miss\":%u,\"merged\":%d,\"solidrect\":%d,\"syncpoint\":%d}}\n",
+					comma ? "," : "", (unsigned long long)d.sel, d.primclass < 4 ? s_primclass[d.primclass] : "?", k, ts, dur,
+					d.frame, d.count, d.prims, d.worker[k].pixels, d.bbox[0], d.bbox[1], d.bbox[2], d.bbox[3], d.tex_hit, d.tex_miss,
+					(d.flags & GSTRACE_MERGED) ? 1 : 0, (d.flags & GSTRACE_SOLIDRECT) ? 1 : 0, (d.flags & GSTRACE_SYNCPOINT) ? 1 : 0);
+
+				comma = true;
+			}
+		}
+
+		fprintf(out, "%s{\"name\":\"vsync\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"args\":{\"frame\":%llu}}\n",
+			comma ? "," : "", (double)(int64_t)(b.tsc - base) / mhz, (unsigned long long)b.frame);
+
+		comma = true;
+	}
+
+	fprintf(out, "]}\n");
+
+	if(out != stdout)
+	{
+		fclose(out);
+	}
+
+	if(summary)
+	{
+		vector<pair<uint64_t, uint64_t> > order;
+
+		for(map<uint64_t, SelStats>::iterator i = sels.begin(); i != sels.end(); i++)
+		{
+			order.push_back(pair<uint64_t, uint64_t>(i->second.ticks, i->first));
+		}
+
+		sort(order.rbegin(), order.rend());
+
+		fprintf(stderr, "%-16s %8s %12s %12s %8s\n", "selector", "draws", "ms", "pixels", "ns/pixel");
+
+		for(size_t i = 0; i < order.size() && i < 20; i++)
+		{
+			const SelStats& s = sels[order[i].second];
+
+			fprintf(stderr, "%016llx %8u %12.3f %12llu %8.2f\n",
+				(unsigned long long)order[i].second, s.draws, s.ticks / mhz / 1000, (unsigned long long)s.pixels,
+				s.pixels > 0 ? s.ticks / mhz * 1000 / s.pixels : 0.0);
+		}
+	}
+
+	return 0;
+}